@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+// Compares decoding a section of pointers one at a time with decodePointer()
+// against decoding it in bulk with decodePointers().
+//
+// Usage: bench_decode_pointers [pointer count] [iterations]
+
+#include "ABI.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ObjectiveNinja;
+
+constexpr uint64_t ImageBase = 0x100000000;
+
+/**
+ * Generate a mix of the pointer kinds found in Objective-C sections: null,
+ * direct, image-relative and tagged.
+ */
+static std::vector<uint64_t> mixedPointers(size_t count)
+{
+    std::mt19937_64 rng(0x6f626a63);
+    std::uniform_int_distribution<uint64_t> offset(0, 0x4000000);
+
+    std::vector<uint64_t> pointers(count);
+    for (auto& pointer : pointers) {
+        switch (rng() % 4) {
+        case 0:
+            pointer = 0;
+            break;
+        case 1:
+            pointer = ImageBase + offset(rng);
+            break;
+        case 2:
+            pointer = offset(rng);
+            break;
+        case 3:
+            pointer = (rng() & ~ABI::PointerMask) | (ImageBase + offset(rng));
+            break;
+        }
+    }
+
+    return pointers;
+}
+
+/**
+ * Run `fn` the given number of times and return the throughput in millions
+ * of pointers per second.
+ */
+template <typename Fn>
+static double measure(size_t count, size_t iterations, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+        fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return static_cast<double>(count) * iterations / elapsed.count() / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    const size_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 200;
+
+    const auto pointers = mixedPointers(count);
+    std::vector<uint64_t> scalar(count);
+    std::vector<uint64_t> bulk(count);
+
+    // Keeps the scalar loop from being optimized away.
+    volatile uint64_t sink = 0;
+
+    auto scalarRate = measure(count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+            scalar[i] = ABI::decodePointer(pointers[i], ImageBase);
+        sink = sink + scalar[count / 2];
+    });
+    auto bulkRate = measure(count, iterations, [&] {
+        ABI::decodePointers(pointers.data(), bulk.data(), count, ImageBase);
+        sink = sink + bulk[count / 2];
+    });
+
+    if (scalar != bulk) {
+        std::fprintf(stderr, "decodePointers() does not match decodePointer()\n");
+        return 1;
+    }
+
+    std::printf("%zu mixed pointers, %zu iterations\n", count, iterations);
+    std::printf("  decodePointer() per pointer: %8.1f Mptr/s\n", scalarRate);
+    std::printf("  decodePointers():            %8.1f Mptr/s (%.1fx)\n", bulkRate, bulkRate / scalarRate);
+
+    return 0;
+}
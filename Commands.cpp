@@ -11,10 +11,17 @@
 #include "CustomTypes.h"
 #include "GlobalState.h"
 #include "InfoHandler.h"
-#include "Performance.h"
+#include "PluginSettings.h"
 
 #include "Core/AnalysisProvider.h"
 #include "Core/BinaryViewFile.h"
+#include "Core/InfoExporter.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 void Commands::defineTypes(BinaryViewRef bv)
 {
@@ -42,14 +49,17 @@ void Commands::analyzeStructures(BinaryViewRef bv)
     try {
         auto file = std::make_shared<ObjectiveNinja::BinaryViewFile>(bv);
 
-        auto start = Performance::now();
-        info = ObjectiveNinja::AnalysisProvider::infoForFile(file);
-        auto elapsed = Performance::elapsed<std::chrono::milliseconds>(start);
+        // Everything is applied at once here, so there is no point in
+        // deferring method lists.
+        auto options = PluginSettings::analysisOptions(bv);
+        options.lazyMethodLists = false;
 
-        const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
-        log->LogInfo("Structures analyzed in %lu ms", elapsed.count());
+        info = InfoHandler::analyzeAndApply(file, options, bv);
 
-        InfoHandler::applyInfoToView(info, bv);
+        const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+        auto cacheStats = file->cacheStats();
+        log->LogDebug("Section cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " bytes",
+            cacheStats.hits, cacheStats.misses, cacheStats.bytes);
     } catch (...) {
         const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
         log->LogError("Structure analysis failed; binary may be malformed.");
@@ -59,10 +69,111 @@ void Commands::analyzeStructures(BinaryViewRef bv)
     GlobalState::setFlag(bv, Flag::DidRunWorkflow);
 }
 
+void Commands::exportAnalysis(BinaryViewRef bv)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+
+    std::string path;
+    if (!BinaryNinja::GetSaveFileNameInput(path, "Export Objective-C Analysis", "*.objcx",
+            bv->GetFile()->GetFilename() + ".objcx"))
+        return;
+
+    std::vector<uint8_t> data;
+    try {
+        // The info kept for the workflow does not hold classes or CFStrings
+        // once they have been applied, so the structures are analyzed again.
+        auto file = std::make_shared<ObjectiveNinja::BinaryViewFile>(bv);
+        auto options = PluginSettings::analysisOptions(bv);
+        options.lazyMethodLists = false;
+
+        auto info = ObjectiveNinja::AnalysisProvider::infoForFile(file, options);
+        data = ObjectiveNinja::InfoExporter::exportInfo(*info);
+    } catch (...) {
+        log->LogError("Structure analysis failed; binary may be malformed.");
+        return;
+    }
+
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!stream) {
+        log->LogError("Failed to write export to '%s'", path.c_str());
+        return;
+    }
+
+    log->LogInfo("Exported Objective-C analysis to '%s' (%zu bytes)", path.c_str(), data.size());
+}
+
+/**
+ * Format a byte count for display.
+ */
+static std::string formatBytes(size_t bytes)
+{
+    char buffer[32];
+    if (bytes >= 1024 * 1024)
+        std::snprintf(buffer, sizeof(buffer), "%.1f MiB", bytes / (1024.0 * 1024.0));
+    else if (bytes >= 1024)
+        std::snprintf(buffer, sizeof(buffer), "%.1f KiB", bytes / 1024.0);
+    else
+        std::snprintf(buffer, sizeof(buffer), "%zu B", bytes);
+
+    return buffer;
+}
+
+void Commands::reportMemoryUsage(BinaryViewRef)
+{
+    std::string report;
+    char line[160];
+
+    for (const auto& view : GlobalState::analyzedViews()) {
+        // Tables of the same name are summed over the view's infos, which
+        // only differ for shared cache views.
+        std::vector<ObjectiveNinja::MemoryUsage::Table> tables;
+        for (const auto& info : view.infos) {
+            for (const auto& table : info->memoryUsage().tables) {
+                auto it = std::find_if(tables.begin(), tables.end(),
+                    [&](const auto& existing) { return std::strcmp(existing.name, table.name) == 0; });
+                if (it == tables.end()) {
+                    tables.push_back(table);
+                } else {
+                    it->count += table.count;
+                    it->bytes += table.bytes;
+                }
+            }
+        }
+
+        if (view.sharedTables)
+            tables.push_back({ "Shared cache strings", view.sharedTables->strings().size(),
+                view.sharedTables->strings().bytes() });
+
+        std::snprintf(line, sizeof(line), "%s (%zu info(s))\n", view.name.c_str(), view.infos.size());
+        report += line;
+
+        size_t total = 0;
+        for (const auto& table : tables) {
+            std::snprintf(line, sizeof(line), "  %-24s %10zu %12s\n", table.name, table.count,
+                formatBytes(table.bytes).c_str());
+            report += line;
+            total += table.bytes;
+        }
+
+        std::snprintf(line, sizeof(line), "  %-24s %10s %12s\n\n", "Total", "", formatBytes(total).c_str());
+        report += line;
+    }
+
+    if (report.empty())
+        report = "No views have been analyzed yet.\n";
+
+    BinaryNinja::ShowPlainTextReport("Objective-C Analysis Memory Usage", report);
+}
+
 void Commands::registerCommands()
 {
     BinaryNinja::PluginCommand::Register("Objective-C \\ Define Types",
         "", Commands::defineTypes);
     BinaryNinja::PluginCommand::Register("Objective-C \\ Analyze Structures",
         "", Commands::analyzeStructures);
+    BinaryNinja::PluginCommand::Register("Objective-C \\ Export Analysis...",
+        "", Commands::exportAnalysis);
+    BinaryNinja::PluginCommand::Register("Objective-C \\ Report Memory Usage",
+        "", Commands::reportMemoryUsage);
 }
@@ -24,6 +24,17 @@ public:
      */
     static void analyzeStructures(BinaryViewRef);
 
+    /**
+     * Analyze all Objective-C structures in the binary and save the results
+     * in the columnar export format, for use by external tools.
+     */
+    static void exportAnalysis(BinaryViewRef);
+
+    /**
+     * Show the memory used by the analysis info of each analyzed view.
+     */
+    static void reportMemoryUsage(BinaryViewRef);
+
     /**
      * Register plugin commands for all one-shot actions.
      */
@@ -8,3 +8,13 @@
 #pragma once
 
 constexpr auto PluginLoggerName = "Plugin.Objective-C";
+
+constexpr auto SettingsGroupName = "objc";
+constexpr auto AnalysisWorkerCountSetting = "objc.analysisWorkerCount";
+constexpr auto LazyMethodListsSetting = "objc.lazyMethodLists";
+constexpr auto StoreAnalysisInViewSetting = "objc.storeAnalysisInView";
+constexpr auto AnalysisCacheDirectorySetting = "objc.analysisCacheDirectory";
+constexpr auto MaxResidentViewsSetting = "objc.maxResidentViews";
+constexpr auto BackgroundAnalysisSetting = "objc.backgroundAnalysis";
+
+constexpr auto SharedCacheViewTypeName = "DSCView";
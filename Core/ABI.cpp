@@ -7,6 +7,16 @@
 
 #include "ABI.h"
 
+#include <limits>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define OBJECTIVENINJA_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OBJECTIVENINJA_NEON 1
+#endif
+
 namespace ObjectiveNinja::ABI {
 
 uint64_t decodePointer(uint64_t pointer, uint64_t imageBase)
@@ -26,4 +36,78 @@ uint64_t decodePointer(uint64_t pointer, uint64_t imageBase)
     return pointer + imageBase;
 }
 
+namespace {
+
+void decodePointersScalar(const uint64_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase)
+{
+    for (size_t i = 0; i < count; ++i)
+        decoded[i] = decodePointer(pointers[i], imageBase);
+}
+
+#if OBJECTIVENINJA_AVX2
+__attribute__((target("avx2"))) void decodePointersAVX2(const uint64_t* pointers, uint64_t* decoded,
+    size_t count, uint64_t imageBase)
+{
+    const auto mask = _mm256_set1_epi64x(static_cast<int64_t>(PointerMask));
+    const auto base = _mm256_set1_epi64x(static_cast<int64_t>(imageBase));
+    const auto zero = _mm256_setzero_si256();
+
+    // AVX2 only has a signed 64-bit comparison; this is equivalent to the
+    // unsigned one as long as the image base is below 2^63, which the caller
+    // checks, since masked pointers are always small and positive.
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto pointer = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pointers + i)), mask);
+        auto keep = _mm256_or_si256(_mm256_cmpeq_epi64(pointer, zero), _mm256_cmpgt_epi64(pointer, base));
+        auto result = _mm256_add_epi64(pointer, _mm256_andnot_si256(keep, base));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(decoded + i), result);
+    }
+
+    decodePointersScalar(pointers + i, decoded + i, count - i, imageBase);
+}
+#endif
+
+#if OBJECTIVENINJA_NEON
+void decodePointersNEON(const uint64_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase)
+{
+    const auto mask = vdupq_n_u64(PointerMask);
+    const auto base = vdupq_n_u64(imageBase);
+    const auto zero = vdupq_n_u64(0);
+
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        auto pointer = vandq_u64(vld1q_u64(pointers + i), mask);
+        auto keep = vorrq_u64(vceqq_u64(pointer, zero), vcgtq_u64(pointer, base));
+        vst1q_u64(decoded + i, vaddq_u64(pointer, vbicq_u64(base, keep)));
+    }
+
+    decodePointersScalar(pointers + i, decoded + i, count - i, imageBase);
+}
+#endif
+
+}
+
+void decodePointers(const uint64_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase)
+{
+#if OBJECTIVENINJA_AVX2
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+    if (hasAVX2 && imageBase <= uint64_t(std::numeric_limits<int64_t>::max()))
+        return decodePointersAVX2(pointers, decoded, count, imageBase);
+#elif OBJECTIVENINJA_NEON
+    return decodePointersNEON(pointers, decoded, count, imageBase);
+#endif
+
+    decodePointersScalar(pointers, decoded, count, imageBase);
+}
+
+void decodePointers(const uint32_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase)
+{
+    // Narrow pointers are widened first; the widening loop and the decoding
+    // loop are both simple enough for the compiler to vectorize.
+    for (size_t i = 0; i < count; ++i)
+        decoded[i] = pointers[i];
+
+    decodePointers(decoded, decoded, count, imageBase);
+}
+
 }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace ObjectiveNinja::ABI {
@@ -21,6 +22,150 @@ constexpr uint64_t PointerMask = 0x7FFFFFFFF;
  */
 constexpr uint64_t FastPointerDataMask = 0b11;
 
+/**
+ * Header shared by method lists and ivar lists.
+ */
+struct ListHeader {
+    uint32_t flags;
+    uint32_t count;
+};
+
+/**
+ * Method list entry using 32-bit offsets relative to each field.
+ */
+struct RelativeMethod {
+    int32_t name;
+    int32_t types;
+    int32_t imp;
+};
+
+/**
+ * Method list entry using absolute pointers.
+ */
+template <typename Pointer>
+struct Method {
+    Pointer name;
+    Pointer types;
+    Pointer imp;
+};
+
+/**
+ * Ivar list entry.
+ */
+template <typename Pointer>
+struct Ivar {
+    Pointer offset;
+    Pointer name;
+    Pointer type;
+    uint32_t alignment;
+    uint32_t size;
+};
+
+/**
+ * Class structure (`objc_class`), up to and including the data pointer.
+ */
+template <typename Pointer>
+struct Class {
+    Pointer isa;
+    Pointer superclass;
+    Pointer cache;
+    Pointer vtable;
+    Pointer data;
+};
+
+/**
+ * Constant CFString instance (`__NSConstantString`).
+ */
+template <typename Pointer>
+struct CFString {
+    Pointer isa;
+    Pointer flags;
+    Pointer data;
+    Pointer size;
+};
+
+/**
+ * Layout traits for 64-bit targets (arm64, arm64e, x86_64).
+ */
+struct LP64 {
+    using Pointer = uint64_t;
+
+    using Method = ABI::Method<Pointer>;
+    using Ivar = ABI::Ivar<Pointer>;
+    using Class = ABI::Class<Pointer>;
+    using CFString = ABI::CFString<Pointer>;
+
+    /**
+     * Read-only class data (`class_ro_t`).
+     */
+    struct ClassRO {
+        uint32_t flags;
+        uint32_t instanceStart;
+        uint32_t instanceSize;
+        uint32_t reserved;
+        Pointer ivarLayout;
+        Pointer name;
+        Pointer baseMethods;
+        Pointer baseProtocols;
+        Pointer ivars;
+        Pointer weakIvarLayout;
+        Pointer baseProperties;
+    };
+};
+
+/**
+ * Layout traits for 32-bit targets (armv7, arm64_32).
+ */
+struct ILP32 {
+    using Pointer = uint32_t;
+
+    using Method = ABI::Method<Pointer>;
+    using Ivar = ABI::Ivar<Pointer>;
+    using Class = ABI::Class<Pointer>;
+    using CFString = ABI::CFString<Pointer>;
+
+    /**
+     * Read-only class data (`class_ro_t`).
+     */
+    struct ClassRO {
+        uint32_t flags;
+        uint32_t instanceStart;
+        uint32_t instanceSize;
+        Pointer ivarLayout;
+        Pointer name;
+        Pointer baseMethods;
+        Pointer baseProtocols;
+        Pointer ivars;
+        Pointer weakIvarLayout;
+        Pointer baseProperties;
+    };
+};
+
+static_assert(sizeof(LP64::Method) == 24 && sizeof(ILP32::Method) == 12);
+static_assert(sizeof(LP64::Ivar) == 32 && sizeof(ILP32::Ivar) == 20);
+static_assert(sizeof(LP64::ClassRO) == 0x48 && sizeof(ILP32::ClassRO) == 0x28);
+static_assert(sizeof(LP64::Class) == 0x28 && sizeof(ILP32::Class) == 0x14);
+static_assert(sizeof(LP64::CFString) == 0x20 && sizeof(ILP32::CFString) == 0x10);
+
+/**
+ * Method list traits for lists using absolute pointers.
+ */
+template <typename Layout>
+struct AbsoluteMethodList {
+    using Entry = typename Layout::Method;
+    static constexpr bool IsRelative = false;
+};
+
+/**
+ * Method list traits for lists using relative offsets.
+ */
+struct RelativeMethodList {
+    using Entry = RelativeMethod;
+    static constexpr bool IsRelative = true;
+};
+
+static_assert(sizeof(RelativeMethodList::Entry) == 12);
+
 /**
  * Automatically resolve a pointer.
  *
@@ -32,4 +177,14 @@ constexpr uint64_t FastPointerDataMask = 0b11;
  */
 uint64_t decodePointer(uint64_t pointer, uint64_t imageBase);
 
+/**
+ * Decode `count` pointers at once, with the same result as calling
+ * decodePointer() on each. `pointers` and `decoded` may be the same array.
+ *
+ * Uses AVX2 or NEON where available; analyzers reading whole sections of
+ * pointers should prefer this over decoding pointers one at a time.
+ */
+void decodePointers(const uint64_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase);
+void decodePointers(const uint32_t* pointers, uint64_t* decoded, size_t count, uint64_t imageBase);
+
 }
@@ -7,6 +7,9 @@
 
 #include "AbstractFile.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace ObjectiveNinja {
 
 uint32_t AbstractFile::readInt(uint64_t offset)
@@ -23,17 +26,36 @@ uint64_t AbstractFile::readLong(uint64_t offset)
 
 std::string AbstractFile::readString(size_t maxLength)
 {
+    // Strings are read in chunks rather than byte-by-byte; most selectors and
+    // type encodings fit in a single chunk.
+    constexpr size_t ChunkSize = 64;
+
+    auto offset = tell();
     std::string result;
+    char chunk[ChunkSize];
 
     while (maxLength == 0 || result.size() <= maxLength) {
-        char c = static_cast<char>(readByte());
+        auto wanted = ChunkSize;
+        if (maxLength != 0)
+            wanted = std::min(wanted, maxLength + 1 - result.size());
 
-        if (c == 0)
+        auto length = readBytes(offset + result.size(), chunk, wanted);
+        if (length == 0)
             break;
 
-        result += c;
+        auto end = static_cast<const char*>(std::memchr(chunk, 0, length));
+        if (end) {
+            result.append(chunk, end - chunk);
+            seek(offset + result.size() + 1);
+            return result;
+        }
+
+        result.append(chunk, length);
+        if (length < wanted)
+            break;
     }
 
+    seek(offset + result.size());
     return result;
 }
 
@@ -8,10 +8,30 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 namespace ObjectiveNinja {
 
+class ChainedFixups;
+
+/**
+ * Exception thrown when a bulk read cannot be fully satisfied.
+ */
+class ReadError : public std::runtime_error {
+public:
+    explicit ReadError(uint64_t offset)
+        : std::runtime_error("Failed to read from file")
+        , offset(offset)
+    {
+    }
+
+    uint64_t offset;
+};
+
 /**
  * A common interface to wrap a file (or another data source) for reading.
  *
@@ -21,6 +41,15 @@ namespace ObjectiveNinja {
  */
 class AbstractFile {
 public:
+    virtual ~AbstractFile() = default;
+
+    /**
+     * Create an independent reader over the same data. Clones share any
+     * immutable state (caches, indices) but have their own reader offset, so
+     * each thread of a parallel analysis can use its own clone.
+     */
+    virtual std::shared_ptr<AbstractFile> clone() const = 0;
+
     /**
      * Seek the reader to the given offset.
      */
@@ -51,6 +80,53 @@ public:
      */
     uint64_t readLong(uint64_t offset);
 
+    /**
+     * Get the current reader offset.
+     */
+    virtual uint64_t tell() const = 0;
+
+    /**
+     * Read up to `length` bytes starting at the given offset into `buffer`,
+     * without moving the reader. Returns the number of bytes actually read,
+     * which may be less than requested near the end of mapped data.
+     */
+    virtual size_t readBytes(uint64_t offset, void* buffer, size_t length) = 0;
+
+    /**
+     * Read a trivially-copyable structure at the given offset in one call.
+     *
+     * Fields are read in host byte order; only little-endian targets are
+     * supported. Throws ReadError if the structure is not fully mapped.
+     */
+    template <typename T>
+    T readStruct(uint64_t offset)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        T result {};
+        if (readBytes(offset, &result, sizeof(T)) != sizeof(T))
+            throw ReadError(offset);
+
+        return result;
+    }
+
+    /**
+     * Read a contiguous array of `count` structures at the given offset in one
+     * call. Throws ReadError if the array is not fully mapped.
+     */
+    template <typename T>
+    std::vector<T> readArray(uint64_t offset, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        std::vector<T> result(count);
+        auto length = count * sizeof(T);
+        if (count && readBytes(offset, result.data(), length) != length)
+            throw ReadError(offset);
+
+        return result;
+    }
+
     /**
      * Read a string starting at the current reader offset. If no max length is
      * specified, a null-terminated string will be read.
@@ -63,6 +139,11 @@ public:
      */
     std::string readStringAt(uint64_t, size_t maxLength = 512);
 
+    /**
+     * Get the size of a pointer in bytes (4 or 8).
+     */
+    virtual size_t pointerSize() const = 0;
+
     /**
      * Get the base offset of the image/file.
      */
@@ -82,6 +163,12 @@ public:
 
     virtual bool hasImportedSymbolAtLocation(uint64_t address) const = 0;
     virtual std::string symbolNameAtLocation(uint64_t address) const = 0;
+
+    /**
+     * Get the chained fixups of the file, if any. Files whose data has
+     * already been fixed up, such as a loaded BinaryView, should return null.
+     */
+    virtual const ChainedFixups* chainedFixups() const { return nullptr; }
 };
 
 }
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Half-open range of addresses.
+ */
+struct AddressRange {
+    uint64_t start;
+    uint64_t end;
+};
+
+/**
+ * Check if an address lies within any of the given ranges, which must be
+ * sorted by start address and not overlap.
+ */
+inline bool rangesContain(const std::vector<AddressRange>& ranges, uint64_t address)
+{
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+        [](uint64_t address, const AddressRange& range) { return address < range.start; });
+    if (it == ranges.begin())
+        return false;
+
+    return address < std::prev(it)->end;
+}
+
+}
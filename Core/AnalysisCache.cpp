@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "AnalysisCache.h"
+
+#include "InfoSerializer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+namespace ObjectiveNinja {
+
+namespace {
+
+constexpr uint32_t MachMagic32 = 0xFEEDFACE;
+constexpr uint32_t MachMagic64 = 0xFEEDFACF;
+
+constexpr uint32_t LoadCommandUUID = 0x1B;
+
+/**
+ * Upper bound on the size of the load commands, to avoid a huge read when
+ * the image base does not actually point at a Mach-O header.
+ */
+constexpr uint32_t MaxCommandsSize = 0x100000;
+
+constexpr size_t HashChunkSize = 0x100000;
+
+struct MachHeader {
+    uint32_t magic;
+    int32_t cpuType;
+    int32_t cpuSubtype;
+    uint32_t fileType;
+    uint32_t commandCount;
+    uint32_t commandsSize;
+    uint32_t flags;
+};
+
+struct UUIDCommand {
+    uint32_t command;
+    uint32_t size;
+    uint8_t uuid[16];
+};
+
+/**
+ * Incremental 64-bit FNV-1a hash.
+ */
+class Hasher {
+    uint64_t m_hash = 0xCBF29CE484222325;
+
+public:
+    void add(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= 0x100000001B3;
+        }
+    }
+
+    template <typename T>
+    void add(T value)
+    {
+        add(&value, sizeof(T));
+    }
+
+    uint64_t value() const { return m_hash; }
+};
+
+/**
+ * Find the UUID in the load commands of the image at the file's image base.
+ * Returns false if there is no header there, or it has no LC_UUID.
+ */
+bool readUUID(AbstractFile& file, std::array<uint8_t, 16>& uuid)
+{
+    const auto base = file.imageBase();
+
+    MachHeader header;
+    if (file.readBytes(base, &header, sizeof(header)) != sizeof(header))
+        return false;
+    if (header.magic != MachMagic32 && header.magic != MachMagic64)
+        return false;
+    if (header.commandsSize > MaxCommandsSize)
+        return false;
+
+    // The 64-bit header has an extra reserved field.
+    auto commandsStart = base + sizeof(MachHeader) + (header.magic == MachMagic64 ? 4 : 0);
+
+    std::vector<uint8_t> commands(header.commandsSize);
+    commands.resize(file.readBytes(commandsStart, commands.data(), commands.size()));
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < header.commandCount && commands.size() - offset >= 8; ++i) {
+        uint32_t command, size;
+        std::memcpy(&command, commands.data() + offset, 4);
+        std::memcpy(&size, commands.data() + offset + 4, 4);
+        if (size < 8 || size > commands.size() - offset)
+            break;
+
+        if (command == LoadCommandUUID && size >= sizeof(UUIDCommand)) {
+            std::memcpy(uuid.data(), commands.data() + offset + offsetof(UUIDCommand, uuid), uuid.size());
+            return true;
+        }
+
+        offset += size;
+    }
+
+    return false;
+}
+
+}
+
+const std::vector<std::string> AnalysisCache::HashedSections = {
+    "__objc_classlist",
+    "__objc_classrefs",
+    "__objc_superrefs",
+    "__objc_selrefs",
+    "__objc_const",
+    "__objc_data",
+    "__objc_methlist",
+    "__objc_methname",
+    "__objc_methtype",
+    "__objc_classname",
+    "__objc_ivar",
+    "__cfstring",
+};
+
+CacheKey CacheKey::forFile(AbstractFile& file)
+{
+    CacheKey key;
+    readUUID(file, key.uuid);
+
+    Hasher hasher;
+    hasher.add<uint64_t>(InfoSerializer::Version);
+    hasher.add<uint64_t>(file.imageBase());
+    hasher.add<uint64_t>(file.pointerSize());
+
+    // Addresses are part of the hash too, since infos are full of them.
+    std::vector<uint8_t> chunk(HashChunkSize);
+    for (const auto& name : AnalysisCache::HashedSections) {
+        auto start = file.sectionStart(name);
+        auto end = file.sectionEnd(name);
+        if (start == 0 || end <= start)
+            continue;
+
+        hasher.add(name.data(), name.size());
+        hasher.add(start);
+        hasher.add(end);
+
+        for (auto address = start; address < end;) {
+            auto length = static_cast<size_t>(std::min<uint64_t>(end - address, chunk.size()));
+            auto read = file.readBytes(address, chunk.data(), length);
+            hasher.add(chunk.data(), read);
+            if (read < length)
+                break;
+
+            address += length;
+        }
+    }
+
+    key.contentHash = hasher.value();
+    return key;
+}
+
+std::string CacheKey::toString() const
+{
+    constexpr auto digits = "0123456789abcdef";
+
+    std::string result;
+    for (auto byte : uuid) {
+        result.push_back(digits[byte >> 4]);
+        result.push_back(digits[byte & 0xF]);
+    }
+
+    result.push_back('-');
+    for (int shift = 60; shift >= 0; shift -= 4)
+        result.push_back(digits[(contentHash >> shift) & 0xF]);
+
+    return result;
+}
+
+AnalysisCache::AnalysisCache(std::string directory)
+    : m_directory(std::move(directory))
+{
+}
+
+std::string AnalysisCache::pathForKey(const CacheKey& key) const
+{
+    return (std::filesystem::path(m_directory) / (key.toString() + ".objcinfo")).string();
+}
+
+bool AnalysisCache::contains(const CacheKey& key) const
+{
+    std::error_code error;
+    return std::filesystem::exists(pathForKey(key), error);
+}
+
+std::shared_ptr<AnalysisInfo> AnalysisCache::load(const CacheKey& key) const
+{
+    std::ifstream stream(pathForKey(key), std::ios::binary);
+    if (!stream)
+        return nullptr;
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (stream.bad())
+        return nullptr;
+
+    try {
+        return InfoSerializer::deserialize(data.data(), data.size());
+    } catch (const SerializationError&) {
+        return nullptr;
+    }
+}
+
+bool AnalysisCache::store(const CacheKey& key, const std::vector<uint8_t>& data) const
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_directory, error);
+    if (error)
+        return false;
+
+    auto path = pathForKey(key);
+    // Writers in other processes may be storing the same entry.
+    auto temporaryPath = path + ".tmp" + std::to_string(std::random_device {}());
+
+    {
+        std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+        stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!stream) {
+            stream.close();
+            std::filesystem::remove(temporaryPath, error);
+            return false;
+        }
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AbstractFile.h"
+#include "AnalysisInfo.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Identifies the Objective-C metadata of an image: its LC_UUID, plus a hash
+ * of the metadata sections and where they are mapped. A rebased or patched
+ * image gets a different key even though its UUID is unchanged.
+ */
+struct CacheKey {
+    std::array<uint8_t, 16> uuid {};
+    uint64_t contentHash {};
+
+    /**
+     * Compute the key of a file. Images without an LC_UUID get an all-zero
+     * UUID and are identified by their content hash alone.
+     */
+    static CacheKey forFile(AbstractFile&);
+
+    /**
+     * Get the key as text, suitable for use as a file name.
+     */
+    std::string toString() const;
+
+    bool operator==(const CacheKey& other) const
+    {
+        return uuid == other.uuid && contentHash == other.contentHash;
+    }
+};
+
+/**
+ * Directory of serialized analysis infos, one file per CacheKey.
+ *
+ * Entries are written to a temporary file and renamed into place, so several
+ * processes may share a directory. Unreadable, stale or corrupt entries are
+ * treated as misses.
+ */
+class AnalysisCache {
+    std::string m_directory;
+
+    std::string pathForKey(const CacheKey&) const;
+
+public:
+    /**
+     * Sections whose contents are covered by the content hash.
+     */
+    static const std::vector<std::string> HashedSections;
+
+    explicit AnalysisCache(std::string directory);
+
+    /**
+     * Check if there is an entry for a key, without validating it.
+     */
+    bool contains(const CacheKey&) const;
+
+    /**
+     * Load the info cached for a key, or null if there is no valid entry.
+     */
+    std::shared_ptr<AnalysisInfo> load(const CacheKey&) const;
+
+    /**
+     * Cache serialized info for a key, creating the directory if needed.
+     * Returns false if the entry could not be written.
+     */
+    bool store(const CacheKey&, const std::vector<uint8_t>& data) const;
+};
+
+}
@@ -8,7 +8,10 @@
 #include "AnalysisInfo.h"
 #include "TypeParser.h"
 
-#include <sstream>
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <unordered_set>
 
 namespace ObjectiveNinja {
 
@@ -16,19 +19,26 @@ constexpr auto FlagsMask = 0xFFFF0000;
 
 std::vector<std::string> MethodInfo::selectorTokens() const
 {
-    std::stringstream r(selector);
-
-    std::string token;
     std::vector<std::string> result;
-    while (std::getline(r, token, ':'))
-        result.push_back(token);
+
+    // Matches the behavior of splitting with std::getline: a trailing ':' does
+    // not produce an empty final token.
+    size_t start = 0;
+    while (start < selector.size()) {
+        auto end = selector.find(':', start);
+        if (end == std::string_view::npos)
+            end = selector.size();
+
+        result.emplace_back(selector.substr(start, end - start));
+        start = end + 1;
+    }
 
     return result;
 }
 
 std::vector<QualifiedNameOrType> MethodInfo::decodedTypeTokens() const
 {
-    return TypeParser::parseEncodedType(type);
+    return TypeParser::parseEncodedType(std::string(type));
 }
 
 bool MethodListInfo::hasRelativeOffsets() const
@@ -43,7 +53,7 @@ bool MethodListInfo::hasDirectSelectors() const
 
 QualifiedNameOrType IvarInfo::decodedTypeToken() const
 {
-    std::vector<QualifiedNameOrType> encodedTypes = TypeParser::parseEncodedType(type);
+    std::vector<QualifiedNameOrType> encodedTypes = TypeParser::parseEncodedType(std::string(type));
 
     if (encodedTypes.size() > 0)
         return encodedTypes.front();
@@ -51,9 +61,195 @@ QualifiedNameOrType IvarInfo::decodedTypeToken() const
         return {};
 }
 
+namespace {
+
+/**
+ * Append a formatted line to a string.
+ */
+template <typename... Args>
+void appendLine(std::string& output, const char* format, Args... args)
+{
+    char buffer[512];
+    auto length = std::snprintf(buffer, sizeof(buffer), format, args...);
+    output.append(buffer, std::min<size_t>(std::max(length, 0), sizeof(buffer) - 1));
+    output.push_back('\n');
+}
+
+void dumpMethodList(std::string& output, const char* prefix, const MethodListInfo& mli)
+{
+    for (const auto& mi : mli.methods)
+        appendLine(output, "    %s%.*s  0x%" PRIx64 "  %.*s", prefix, int(mi.selector.size()), mi.selector.data(),
+            mi.implAddress, int(mi.type.size()), mi.type.data());
+}
+
+void dumpClassRefs(std::string& output, const char* kind, const std::vector<ClassRefInfo>& refs)
+{
+    for (const auto& ref : refs) {
+        if (ref.importedName.empty())
+            appendLine(output, "  0x%" PRIx64 " %s 0x%" PRIx64, ref.address, kind, ref.referencedAddress);
+        else
+            appendLine(output, "  0x%" PRIx64 " %s %.*s", ref.address, kind, int(ref.importedName.size()),
+                ref.importedName.data());
+    }
+}
+
+}
+
 std::string AnalysisInfo::dump() const
 {
-    return "<unimplemented>";
+    std::string output;
+
+    appendLine(output, "Classes (%zu):", classes.size());
+    for (const auto& ci : classes) {
+        appendLine(output, "  0x%" PRIx64 " %.*s", ci.address, int(ci.name.size()), ci.name.data());
+
+        if (ci.ivarList) {
+            for (const auto& ii : ci.ivarList->ivars)
+                appendLine(output, "    ivar %.*s  +0x%x  %.*s", int(ii.name.size()), ii.name.data(), ii.offset,
+                    int(ii.type.size()), ii.type.data());
+        }
+        if (ci.metaClassInfo && ci.metaClassInfo->info.methodList)
+            dumpMethodList(output, "+", *ci.metaClassInfo->info.methodList);
+        if (ci.methodList)
+            dumpMethodList(output, "-", *ci.methodList);
+    }
+
+    if (hasDeferredMethods())
+        appendLine(output, "  (method lists not yet resolved)");
+
+    appendLine(output, "CFStrings (%zu):", cfStrings.size());
+    for (const auto& csi : cfStrings)
+        appendLine(output, "  0x%" PRIx64 " -> 0x%" PRIx64 " (%zu bytes)", csi.address, csi.dataAddress, csi.size);
+
+    appendLine(output, "Class references (%zu):", classRefs.size() + superRefs.size());
+    dumpClassRefs(output, "class", classRefs);
+    dumpClassRefs(output, "super", superRefs);
+
+    appendLine(output, "Selector references (%zu):", selectorRefs.size());
+    for (const auto sr : selectorRefs)
+        appendLine(output, "  0x%" PRIx64 " %.*s", sr.address, int(sr.name.size()), sr.name.data());
+
+    return output;
+}
+
+void AnalysisInfo::buildDispatchIndex()
+{
+    dispatchIndex = DispatchIndex(methodImpls);
+
+    // Swapped rather than cleared, so the buckets are freed too.
+    std::unordered_map<uint64_t, uint64_t>().swap(methodImpls);
+}
+
+size_t MemoryUsage::bytes() const
+{
+    size_t total = 0;
+    for (const auto& table : tables)
+        total += table.bytes;
+
+    return total;
+}
+
+MemoryUsage AnalysisInfo::memoryUsage() const
+{
+    std::scoped_lock<std::mutex> lock(m_recordsMutex);
+
+    MemoryUsage usage;
+    auto add = [&](const char* name, size_t count, size_t bytes) {
+        usage.tables.push_back({ name, count, bytes });
+    };
+
+    add("Classes", classes.size(), classes.capacity() * sizeof(ClassInfo));
+
+    // Lists are being filled in while deferred methods are resolved, and
+    // cannot be inspected until that is done.
+    if (!hasDeferredMethods()) {
+        std::unordered_set<const MethodListInfo*> methodLists;
+        std::unordered_set<const IvarListInfo*> ivarLists;
+        std::unordered_set<const MetaClassInfo*> metaClasses;
+
+        size_t methodCount = 0;
+        size_t methodBytes = 0;
+        size_t ivarCount = 0;
+        size_t ivarBytes = 0;
+
+        auto addClass = [&](const ClassInfo& ci) {
+            if (ci.methodList && methodLists.insert(ci.methodList.get()).second) {
+                methodCount += ci.methodList->methods.size();
+                methodBytes += sizeof(MethodListInfo) + ci.methodList->methods.capacity() * sizeof(MethodInfo);
+            }
+            if (ci.ivarList && ivarLists.insert(ci.ivarList.get()).second) {
+                ivarCount += ci.ivarList->ivars.size();
+                ivarBytes += sizeof(IvarListInfo) + ci.ivarList->ivars.capacity() * sizeof(IvarInfo);
+            }
+        };
+
+        for (const auto& ci : classes) {
+            addClass(ci);
+            if (ci.metaClassInfo && metaClasses.insert(ci.metaClassInfo).second)
+                addClass(ci.metaClassInfo->info);
+        }
+
+        add("Metaclasses", metaClasses.size(), metaClasses.size() * sizeof(MetaClassInfo));
+        add("Methods", methodCount, methodBytes);
+        add("Ivars", ivarCount, ivarBytes);
+    }
+
+    add("CFStrings", cfStrings.size(), cfStrings.capacity() * sizeof(CFStringInfo));
+    add("Class references", classRefs.size() + superRefs.size(),
+        (classRefs.capacity() + superRefs.capacity()) * sizeof(ClassRefInfo));
+    add("Selector references", selectorRefs.size(), selectorRefs.bytes());
+
+    // Both tables are filled in by the resolver as well, without the lock;
+    // they are empty until it is done anyway.
+    if (!hasDeferredMethods()) {
+        // Estimated as one node (value plus next pointer) per entry, plus the
+        // bucket array.
+        add("Method implementations", methodImpls.size(),
+            methodImpls.size() * (sizeof(decltype(methodImpls)::value_type) + sizeof(void*))
+                + methodImpls.bucket_count() * sizeof(void*));
+        add("Dispatch index", dispatchIndex.size(), dispatchIndex.bytes());
+    }
+
+    add("String pool", strings.size(), strings.bytes());
+    if (stringSections)
+        add("String sections", 0, stringSections->bytes());
+
+    return usage;
+}
+
+void AnalysisInfo::releaseRecords()
+{
+    std::scoped_lock<std::mutex> lock(m_recordsMutex);
+
+    // Swapped with empty vectors, so that their capacity is freed as well.
+    std::vector<ClassInfo>().swap(classes);
+    std::vector<std::unique_ptr<MetaClassInfo>>().swap(metaClasses);
+    std::vector<CFStringInfo>().swap(cfStrings);
+}
+
+void AnalysisInfo::deferMethods(std::function<void(std::shared_ptr<AnalysisInfo>, std::shared_ptr<AbstractFile>)> resolve)
+{
+    m_resolveMethods = std::move(resolve);
+    m_methodsDeferred = true;
+}
+
+bool AnalysisInfo::resolveMethods(const std::function<std::shared_ptr<AbstractFile>()>& openFile)
+{
+    bool resolved = false;
+    std::call_once(m_methodsResolved, [&] {
+        if (!m_resolveMethods)
+            return;
+
+        // The resolver is only released once it succeeds; if it throws,
+        // call_once lets the next caller run it again.
+        m_resolveMethods(shared_from_this(), openFile());
+        m_resolveMethods = nullptr;
+        m_methodsDeferred = false;
+
+        resolved = true;
+    });
+
+    return resolved;
 }
 
 }
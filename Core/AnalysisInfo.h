@@ -7,14 +7,26 @@
 
 #pragma once
 
+#include "DispatchIndex.h"
+#include "SelectorTable.h"
+#include "SharedCacheTables.h"
+#include "StringPool.h"
+#include "StringSectionIndex.h"
 #include "TypeParser.h"
+
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace ObjectiveNinja {
 
+class AbstractFile;
+
 /**
  * A description of a CFString instance.
  */
@@ -24,28 +36,14 @@ struct CFStringInfo {
     size_t size {};
 };
 
-/**
- * A description of a selector reference.
- */
-struct SelectorRefInfo {
-    uint64_t address {};
-
-    std::string name {};
-
-    uint64_t rawSelector {};
-    uint64_t nameAddress {};
-};
-
-using SharedSelectorRefInfo = std::shared_ptr<SelectorRefInfo>;
-
 /**
  * A description of an Objective-C method.
  */
 struct MethodInfo {
     uint64_t address {};
 
-    std::string selector;
-    std::string type;
+    std::string_view selector;
+    std::string_view type;
 
     uint64_t nameAddress {};
     uint64_t typeAddress {};
@@ -90,13 +88,13 @@ struct IvarInfo {
     uint64_t address = {};
 
     uint32_t offset;
-    std::string name;
-    std::string type;
+    uint32_t size {};
+    std::string_view name;
+    std::string_view type;
 
     uint64_t offsetAddress {};
     uint64_t nameAddress {};
     uint64_t typeAddress {};
-    uint32_t size {};
 
     /**
      * Get the instance variable's type as a C-style token.
@@ -120,12 +118,18 @@ struct IvarListInfo {
 struct ClassInfo {
     uint64_t address {};
 
-    bool isMetaClass;
-    MetaClassInfo* metaClassInfo;
+    bool isMetaClass {};
+    MetaClassInfo* metaClassInfo {};
 
-    std::string name {};
-    MethodListInfo methodList {};
-    IvarListInfo ivarList {};
+    std::string_view name {};
+
+    /**
+     * Parsed method and ivar lists, or null if the class has none. Lists are
+     * parsed once per address and shared between all classes referencing
+     * them.
+     */
+    std::shared_ptr<const MethodListInfo> methodList {};
+    std::shared_ptr<const IvarListInfo> ivarList {};
 
     uint64_t listPointer {};
     uint64_t dataAddress {};
@@ -135,14 +139,41 @@ struct ClassInfo {
 };
 
 struct MetaClassInfo {
-    std::string name {};
-    bool imported;
+    std::string_view name {};
+    bool imported {};
     ClassInfo info {};
 };
 
+/**
+ * A description of a class or superclass reference.
+ */
 struct ClassRefInfo {
     uint64_t address;
     uint64_t referencedAddress;
+
+    /**
+     * Name of the referenced class if it is imported from another image,
+     * otherwise empty.
+     */
+    std::string_view importedName {};
+};
+
+/**
+ * Approximate memory used by each table of an AnalysisInfo.
+ */
+struct MemoryUsage {
+    struct Table {
+        const char* name;
+        size_t count;
+        size_t bytes;
+    };
+
+    std::vector<Table> tables;
+
+    /**
+     * Get the total number of bytes used by all tables.
+     */
+    size_t bytes() const;
 };
 
 /**
@@ -151,19 +182,122 @@ struct ClassRefInfo {
  * AnalysisInfo is intended to be a common structure for persisting information
  * during and after analysis. All significant info obtained or produced through
  * analysis should be stored here, ideally in the form of other *Info structs.
+ *
+ * All strings referenced by the other *Info structs are views into `strings`,
+ * `stringSections` or `sharedTables`, and therefore share the lifetime of the
+ * AnalysisInfo they belong to.
  */
-struct AnalysisInfo {
+struct AnalysisInfo : std::enable_shared_from_this<AnalysisInfo> {
+    StringPool strings {};
+
+    /**
+     * Index of the selector, type and class name string sections, if built.
+     * Strings inside these sections are served from here instead of `strings`.
+     */
+    std::shared_ptr<const StringSectionIndex> stringSections {};
+
+    /**
+     * Tables shared with other images from the same shared cache, if any.
+     * When set, strings are pooled in the shared tables rather than
+     * `strings`.
+     */
+    std::shared_ptr<SharedCacheTables> sharedTables {};
+
     std::vector<CFStringInfo> cfStrings {};
 
     std::vector<ClassRefInfo> classRefs {};
     std::vector<ClassRefInfo> superRefs {};
-    std::vector<SharedSelectorRefInfo> selectorRefs {};
-    std::unordered_map<uint64_t, SharedSelectorRefInfo> selectorRefsByKey {};
+    SelectorTable selectorRefs {};
 
     std::vector<ClassInfo> classes {};
+
+    /**
+     * Storage for the metaclasses referenced by `classes`.
+     */
+    std::vector<std::unique_ptr<MetaClassInfo>> metaClasses {};
+
+    /**
+     * Name of the image the info was produced for, if it was analyzed as
+     * one of several images of a shared cache.
+     */
+    std::string imageName {};
+
+    /**
+     * Method implementations by selector, filled during analysis. Emptied
+     * once `dispatchIndex` is built from it.
+     */
     std::unordered_map<uint64_t, uint64_t> methodImpls;
 
+    /**
+     * Read-only index of method implementations, built once analysis is
+     * complete. Lookups after analysis must use this.
+     */
+    DispatchIndex dispatchIndex {};
+
     std::string dump() const;
+
+    /**
+     * Build `dispatchIndex` from `methodImpls`, then release `methodImpls`.
+     */
+    void buildDispatchIndex();
+
+    /**
+     * Get the memory used by each table. Method and ivar lists shared between
+     * classes are counted once. Strings pooled in shared cache tables are not
+     * counted, as they belong to every image of the cache. Tables filled in
+     * by resolveMethods() are left out while methods are deferred, so this
+     * may be called while they are being resolved.
+     */
+    MemoryUsage memoryUsage() const;
+
+    /**
+     * Free the classes, metaclasses and CFStrings (along with the method and
+     * ivar lists only they reference), once they have been applied and
+     * cached. Lookups only need the selector references, class references
+     * and dispatch index, which are kept. May be called while memoryUsage()
+     * runs on another thread.
+     */
+    void releaseRecords();
+
+    /**
+     * Defer the parsing of method lists until resolveMethods() is called.
+     * Until then, `ClassInfo::methodList`, `methodImpls` and `dispatchIndex`
+     * are left empty.
+     *
+     * `resolve` is given the file to read the method lists from, so that the
+     * info does not keep the file (and whatever it reads from) alive.
+     */
+    void deferMethods(std::function<void(std::shared_ptr<AnalysisInfo>, std::shared_ptr<AbstractFile>)> resolve);
+
+    /**
+     * Tells whether method lists have been deferred and not yet resolved.
+     */
+    bool hasDeferredMethods() const { return m_methodsDeferred; }
+
+    /**
+     * Resolve deferred method lists, if any. Safe to call from any number of
+     * threads; resolution happens exactly once, and other callers block until
+     * it is complete. Returns true if methods were resolved by this call, in
+     * which case anything that should follow resolution (such as applying
+     * method info) is left to the caller, without holding up the others.
+     *
+     * If resolution throws, the exception is propagated to the caller that
+     * triggered it, methods remain unresolved, and the next call tries again.
+     *
+     * `openFile` is only called if methods are resolved by this call.
+     */
+    bool resolveMethods(const std::function<std::shared_ptr<AbstractFile>()>& openFile);
+
+private:
+    std::function<void(std::shared_ptr<AnalysisInfo>, std::shared_ptr<AbstractFile>)> m_resolveMethods;
+    std::atomic<bool> m_methodsDeferred { false };
+    std::once_flag m_methodsResolved;
+
+    /**
+     * Held by releaseRecords() and memoryUsage(), which may be called on
+     * different threads once the info is shared.
+     */
+    mutable std::mutex m_recordsMutex;
 };
 
 }
@@ -7,27 +7,98 @@
 
 #include "AnalysisProvider.h"
 
-#include "Analyzers/CFStringAnalyzer.h"
-#include "Analyzers/ClassAnalyzer.h"
-#include "Analyzers/ClassRefAnalyzer.h"
-#include "Analyzers/SelectorAnalyzer.h"
+#include "AnalyzerRegistry.h"
+#include "ThreadPool.h"
 
 namespace ObjectiveNinja {
 
-SharedAnalysisInfo AnalysisProvider::infoForFile(SharedAbstractFile file)
+SharedAnalysisInfo AnalysisProvider::infoForFile(SharedAbstractFile file, const AnalysisOptions& options,
+    RecordQueue* records)
 {
     auto info = std::make_shared<ObjectiveNinja::AnalysisInfo>();
+    runAnalyzers(info, std::move(file), options, records);
 
-    std::vector<std::unique_ptr<ObjectiveNinja::Analyzer>> analyzers;
-    analyzers.emplace_back(new SelectorAnalyzer(info, file));
-    analyzers.emplace_back(new ClassAnalyzer(info, file));
-    analyzers.emplace_back(new CFStringAnalyzer(info, file));
-    analyzers.emplace_back(new ClassRefAnalyzer(info, file));
+    return info;
+}
 
-    for (const auto& analyzer : analyzers)
-        analyzer->run();
+std::vector<SharedAnalysisInfo> AnalysisProvider::infoForImages(const std::vector<SharedAbstractFile>& images,
+    std::shared_ptr<SharedCacheTables> tables, const AnalysisOptions& options, std::vector<std::exception_ptr>* errors)
+{
+    std::vector<SharedAnalysisInfo> infos(images.size());
+    if (errors)
+        errors->assign(images.size(), nullptr);
 
-    return info;
+    // Parallelism comes from analyzing images side by side; splitting each
+    // image's work as well would only oversubscribe the machine.
+    auto imageOptions = options;
+    if (images.size() > 1)
+        imageOptions.workerCount = 1;
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < images.size(); ++i) {
+        tasks.emplace_back([&, i] {
+            auto info = std::make_shared<ObjectiveNinja::AnalysisInfo>();
+            info->sharedTables = tables;
+
+            // A malformed image should not prevent the others from being
+            // analyzed; it is simply left without info, and the error is
+            // handed back to the caller.
+            try {
+                runAnalyzers(info, images[i], imageOptions, nullptr);
+                infos[i] = std::move(info);
+            } catch (...) {
+                if (errors)
+                    (*errors)[i] = std::current_exception();
+            }
+        });
+    }
+
+    ThreadPool pool(options.workerCount);
+    pool.runAll(std::move(tasks));
+
+    for (const auto& info : infos)
+        if (info)
+            tables->addClasses(info->classes);
+
+    return infos;
+}
+
+void AnalysisProvider::runAnalyzers(SharedAnalysisInfo info, SharedAbstractFile file, const AnalysisOptions& options,
+    RecordQueue* records)
+{
+    info->stringSections = StringSectionIndex::build(*file);
+
+    const auto registry = AnalyzerRegistry::defaultRegistry();
+    ThreadPool pool(options.workerCount);
+
+    for (const auto& wave : registry.schedule()) {
+        std::vector<std::function<void()>> tasks;
+
+        // Analyzers in the same wave run concurrently, so each one gets its
+        // own reader. Since every field has exactly one producer, results land
+        // in the same place regardless of completion order.
+        for (const auto* descriptor : wave) {
+            auto reader = tasks.empty() ? file : file->clone();
+            tasks.emplace_back([descriptor, info, reader, &pool, &options, records] {
+                auto analyzer = descriptor->create(info, reader);
+                analyzer->setThreadPool(&pool);
+                analyzer->setOptions(options);
+                analyzer->setRecordQueue(records);
+                analyzer->run();
+            });
+        }
+
+        pool.runAll(std::move(tasks));
+
+        // The queue is only closed early if its consumer gave up; later
+        // waves are not worth running then.
+        if (records && records->closed())
+            throw AnalysisCancelled();
+    }
+
+    // With deferred method lists, the index is built once they are resolved.
+    if (!info->hasDeferredMethods())
+        info->buildDispatchIndex();
 }
 
 }
@@ -9,6 +9,8 @@
 
 #include "Analyzer.h"
 
+#include <exception>
+
 namespace ObjectiveNinja {
 
 /**
@@ -19,8 +21,38 @@ public:
     /**
      * Run the default suite of analyzers on an abstract file and get the
      * resulting AnalysisInfo.
+     *
+     * Independent analyzers run concurrently on a pool of
+     * `options.workerCount` threads. Analyzers that support it (such as the
+     * class analyzer) also split their own work across the same pool.
+     *
+     * If a record queue is given, classes and CFStrings are streamed to it as
+     * they are found instead of being stored in the returned info, which then
+     * only holds selector references, class references and method
+     * implementations. The queue is not closed when analysis finishes.
+     */
+    static SharedAnalysisInfo infoForFile(SharedAbstractFile, const AnalysisOptions& options = {},
+        RecordQueue* records = nullptr);
+
+    /**
+     * Analyze several images from the same shared cache, sharing the given
+     * tables between them. Images are analyzed concurrently, each on a
+     * single thread, and their classes are added to the class table once
+     * all of them are done. Infos are returned in the order of `images`;
+     * images whose analysis failed get a null info.
+     *
+     * If given, `errors` receives the exception each failed image was
+     * analyzed with, also in the order of `images`, and null for the others.
+     */
+    static std::vector<SharedAnalysisInfo> infoForImages(const std::vector<SharedAbstractFile>& images,
+        std::shared_ptr<SharedCacheTables> tables, const AnalysisOptions& options = {},
+        std::vector<std::exception_ptr>* errors = nullptr);
+
+private:
+    /**
+     * Run the default suite of analyzers, storing results in `info`.
      */
-    static SharedAnalysisInfo infoForFile(SharedAbstractFile);
+    static void runAnalyzers(SharedAnalysisInfo info, SharedAbstractFile, const AnalysisOptions&, RecordQueue*);
 };
 
 }
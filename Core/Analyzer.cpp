@@ -12,5 +12,19 @@ using namespace ObjectiveNinja;
 Analyzer::Analyzer(SharedAnalysisInfo info, SharedAbstractFile file)
     : m_info(std::move(info))
     , m_file(std::move(file))
+    , m_fixups(m_file->chainedFixups())
 {
 }
+
+std::string_view Analyzer::readStringAt(uint64_t address)
+{
+    if (m_info->stringSections)
+        if (auto indexed = m_info->stringSections->stringAt(address))
+            return *indexed;
+
+    auto& pool = m_info->sharedTables ? m_info->sharedTables->strings() : m_info->strings;
+    if (auto cached = pool.find(address))
+        return *cached;
+
+    return pool.intern(address, m_file->readStringAt(address));
+}
@@ -10,14 +10,36 @@
 #include "ABI.h"
 #include "AbstractFile.h"
 #include "AnalysisInfo.h"
+#include "ChainedFixups.h"
+#include "RecordQueue.h"
 
 #include <memory>
+#include <vector>
 
 namespace ObjectiveNinja {
 
+class ThreadPool;
+
 using SharedAnalysisInfo = std::shared_ptr<AnalysisInfo>;
 using SharedAbstractFile = std::shared_ptr<AbstractFile>;
 
+/**
+ * Options controlling how analysis is performed.
+ */
+struct AnalysisOptions {
+    /**
+     * Number of worker threads to use; if zero, the number of hardware
+     * threads is used.
+     */
+    unsigned workerCount = 0;
+
+    /**
+     * Only index classes up front, and defer parsing method lists until
+     * AnalysisInfo::resolveMethods() is called.
+     */
+    bool lazyMethodLists = false;
+};
+
 /**
  * Abstract base class for analyzers.
  */
@@ -26,6 +48,24 @@ protected:
     std::shared_ptr<AnalysisInfo> m_info;
     std::shared_ptr<AbstractFile> m_file;
 
+    /**
+     * Pool available for splitting the analyzer's own work, if any.
+     */
+    ThreadPool* m_pool = nullptr;
+
+    AnalysisOptions m_options {};
+
+    /**
+     * Queue to stream records to, if any. Analyzers that support streaming
+     * send their records here instead of storing them in the AnalysisInfo.
+     */
+    RecordQueue* m_records = nullptr;
+
+    /**
+     * Chained fixups of the file, if any; owned by the file.
+     */
+    const ChainedFixups* m_fixups = nullptr;
+
     /**
      * Automatically resolve a pointer.
      */
@@ -34,10 +74,98 @@ protected:
         return ABI::decodePointer(pointer, m_file->imageBase());
     }
 
+    /**
+     * Resolve the pointer `pointer`, read from `location`. If the file has a
+     * chained fixup at that location, its target is used as-is (zero for
+     * binds); otherwise, the pointer is decoded heuristically.
+     */
+    uint64_t arp(uint64_t location, uint64_t pointer) const
+    {
+        if (m_fixups)
+            if (auto fixup = m_fixups->find(location))
+                return fixup->target;
+
+        return arp(pointer);
+    }
+
+    /**
+     * Resolve an array of pointers in a single pass. Pointer `i` is assumed
+     * to have been read from `firstLocation + i * stride`, which is used to
+     * apply chained fixups, if any.
+     */
+    template <typename Pointer>
+    std::vector<uint64_t> arp(const std::vector<Pointer>& pointers, uint64_t firstLocation,
+        size_t stride = sizeof(Pointer)) const
+    {
+        std::vector<uint64_t> decoded(pointers.size());
+        ABI::decodePointers(pointers.data(), decoded.data(), pointers.size(), m_file->imageBase());
+
+        if (m_fixups && !pointers.empty()) {
+            auto [first, last] = m_fixups->range(firstLocation, firstLocation + pointers.size() * stride);
+            for (auto fixup = first; fixup != last; ++fixup)
+                if ((fixup->location - firstLocation) % stride == 0)
+                    decoded[(fixup->location - firstLocation) / stride] = fixup->target;
+        }
+
+        return decoded;
+    }
+
+    /**
+     * Get the value a loader would leave at `location`, where `pointer` is
+     * stored in the file: the chained fixup target if there is one,
+     * otherwise the pointer unchanged.
+     */
+    uint64_t fixedUp(uint64_t location, uint64_t pointer) const
+    {
+        if (m_fixups)
+            if (auto fixup = m_fixups->find(location))
+                return fixup->target;
+
+        return pointer;
+    }
+
+    /**
+     * Invoke `fn` with an instance of the ABI layout traits (ABI::LP64 or
+     * ABI::ILP32) matching the file's pointer size. Analyzers dispatch once
+     * per run through this so their parsing loops are fully specialized.
+     */
+    template <typename Fn>
+    void withLayout(Fn&& fn) const
+    {
+        if (m_file->pointerSize() == 4)
+            fn(ABI::ILP32 {});
+        else
+            fn(ABI::LP64 {});
+    }
+
+    /**
+     * Read a string at the given address. Strings in the indexed string
+     * sections are served directly from the index; others go through the
+     * info's string pool (or the shared cache's, if any), so repeated reads
+     * of the same address are free.
+     */
+    std::string_view readStringAt(uint64_t address);
+
 public:
     Analyzer(SharedAnalysisInfo, SharedAbstractFile);
     virtual ~Analyzer() = default;
 
+    /**
+     * Allow the analyzer to split its work across the given pool. Analyzers
+     * that do not support this ignore it and run serially.
+     */
+    void setThreadPool(ThreadPool* pool) { m_pool = pool; }
+
+    /**
+     * Set the options for the analyzer to honor.
+     */
+    void setOptions(const AnalysisOptions& options) { m_options = options; }
+
+    /**
+     * Stream records to the given queue rather than storing them.
+     */
+    void setRecordQueue(RecordQueue* records) { m_records = records; }
+
     virtual void run() = 0;
 };
 
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "AnalyzerRegistry.h"
+
+#include "Analyzers/CFStringAnalyzer.h"
+#include "Analyzers/ClassAnalyzer.h"
+#include "Analyzers/ClassRefAnalyzer.h"
+#include "Analyzers/SelectorAnalyzer.h"
+
+#include <stdexcept>
+
+namespace ObjectiveNinja {
+
+template <typename T>
+static std::unique_ptr<Analyzer> createAnalyzer(SharedAnalysisInfo info, SharedAbstractFile file)
+{
+    return std::make_unique<T>(std::move(info), std::move(file));
+}
+
+AnalyzerRegistry AnalyzerRegistry::defaultRegistry()
+{
+    AnalyzerRegistry registry;
+    registry.add({ "SelectorAnalyzer", InfoField::SelectorRefs, InfoField::None,
+        createAnalyzer<SelectorAnalyzer> });
+    registry.add({ "ClassAnalyzer", InfoField::Classes | InfoField::MethodImpls, InfoField::None,
+        createAnalyzer<ClassAnalyzer> });
+    registry.add({ "CFStringAnalyzer", InfoField::CFStrings, InfoField::None,
+        createAnalyzer<CFStringAnalyzer> });
+    registry.add({ "ClassRefAnalyzer", InfoField::ClassRefs | InfoField::SuperRefs, InfoField::None,
+        createAnalyzer<ClassRefAnalyzer> });
+
+    return registry;
+}
+
+void AnalyzerRegistry::add(AnalyzerDescriptor descriptor)
+{
+    for (const auto& existing : m_descriptors)
+        if (existing.produces & descriptor.produces)
+            throw std::logic_error(descriptor.name + " produces a field already produced by " + existing.name);
+
+    m_descriptors.push_back(std::move(descriptor));
+}
+
+std::vector<std::vector<const AnalyzerDescriptor*>> AnalyzerRegistry::schedule() const
+{
+    std::vector<std::vector<const AnalyzerDescriptor*>> waves;
+    std::vector<bool> scheduled(m_descriptors.size());
+    size_t remaining = m_descriptors.size();
+
+    // Fields that will still be produced by analyzers that are not yet in a
+    // finished wave.
+    InfoField::Set pending = InfoField::None;
+    for (const auto& descriptor : m_descriptors)
+        pending |= descriptor.produces;
+
+    while (remaining > 0) {
+        std::vector<const AnalyzerDescriptor*> wave;
+        InfoField::Set produced = InfoField::None;
+
+        for (size_t i = 0; i < m_descriptors.size(); ++i) {
+            if (scheduled[i] || (m_descriptors[i].consumes & pending))
+                continue;
+
+            wave.push_back(&m_descriptors[i]);
+            produced |= m_descriptors[i].produces;
+            scheduled[i] = true;
+        }
+
+        if (wave.empty())
+            throw std::logic_error("Analyzer dependencies contain a cycle");
+
+        pending &= ~produced;
+        remaining -= wave.size();
+        waves.push_back(std::move(wave));
+    }
+
+    return waves;
+}
+
+}
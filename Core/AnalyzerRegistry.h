@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "Analyzer.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Flags naming the AnalysisInfo fields an analyzer produces or consumes.
+ */
+namespace InfoField {
+
+using Set = uint32_t;
+
+constexpr Set None = 0;
+constexpr Set CFStrings = 1 << 0;
+constexpr Set SelectorRefs = 1 << 1;
+constexpr Set Classes = 1 << 2;
+constexpr Set MethodImpls = 1 << 3;
+constexpr Set ClassRefs = 1 << 4;
+constexpr Set SuperRefs = 1 << 5;
+
+}
+
+/**
+ * Description of an analyzer and its data dependencies.
+ */
+struct AnalyzerDescriptor {
+    std::string name;
+
+    /**
+     * Fields written by the analyzer. No two analyzers may produce the same
+     * field, which keeps concurrent analyzers from writing to shared state
+     * (other than the thread-safe string pool).
+     */
+    InfoField::Set produces = InfoField::None;
+
+    /**
+     * Fields read by the analyzer, which must be fully produced before the
+     * analyzer runs.
+     */
+    InfoField::Set consumes = InfoField::None;
+
+    std::function<std::unique_ptr<Analyzer>(SharedAnalysisInfo, SharedAbstractFile)> create;
+};
+
+/**
+ * Registry of analyzers to run, and scheduler for running them.
+ */
+class AnalyzerRegistry {
+    std::vector<AnalyzerDescriptor> m_descriptors;
+
+public:
+    /**
+     * Get a registry containing the default suite of analyzers.
+     */
+    static AnalyzerRegistry defaultRegistry();
+
+    /**
+     * Register an analyzer.
+     */
+    void add(AnalyzerDescriptor);
+
+    /**
+     * Group the registered analyzers into waves. Analyzers within a wave are
+     * independent of each other and may run concurrently; every wave only
+     * depends on the waves before it. Analyzers keep their registration order
+     * within a wave.
+     *
+     * Throws std::logic_error if two analyzers produce the same field or if
+     * the dependencies contain a cycle.
+     */
+    std::vector<std::vector<const AnalyzerDescriptor*>> schedule() const;
+};
+
+}
@@ -7,27 +7,66 @@
 
 #include "CFStringAnalyzer.h"
 
+#include <utility>
+
 using namespace ObjectiveNinja;
 
+/**
+ * Number of CFStrings to send to the record queue at once, if streaming.
+ */
+constexpr size_t RecordsPerBatch = 1024;
+
 CFStringAnalyzer::CFStringAnalyzer(SharedAnalysisInfo info,
     SharedAbstractFile file)
     : Analyzer(std::move(info), std::move(file))
 {
 }
 
-void CFStringAnalyzer::run()
+template <typename Layout>
+void CFStringAnalyzer::analyzeCFStrings()
 {
+    using Entry = typename Layout::CFString;
+
     const auto sectionStart = m_file->sectionStart("__cfstring");
     const auto sectionEnd = m_file->sectionEnd("__cfstring");
     if (sectionStart == 0 || sectionEnd == 0)
         return;
 
-    for (auto address = sectionStart; address < sectionEnd; address += 0x20) {
+    auto count = (sectionEnd - sectionStart) / sizeof(Entry);
+    auto entries = m_file->readArray<Entry>(sectionStart, count);
+
+    std::vector<typename Layout::Pointer> dataPointers(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i)
+        dataPointers[i] = entries[i].data;
+    const auto dataAddresses = arp(dataPointers, sectionStart + offsetof(Entry, data), sizeof(Entry));
+
+    if (!m_records)
+        m_info->cfStrings.reserve(m_info->cfStrings.size() + count);
+
+    std::vector<AnalysisRecord> batch;
+    for (size_t i = 0; i < entries.size(); ++i) {
         CFStringInfo cfString;
-        cfString.address = address;
-        cfString.dataAddress = arp(m_file->readLong(address + 0x10));
-        cfString.size = m_file->readLong(address + 0x18);
+        cfString.address = sectionStart + (i * sizeof(Entry));
+        cfString.dataAddress = dataAddresses[i];
+        cfString.size = entries[i].size;
+
+        if (!m_records) {
+            m_info->cfStrings.emplace_back(cfString);
+            continue;
+        }
 
-        m_info->cfStrings.emplace_back(cfString);
+        batch.emplace_back(cfString);
+        if (batch.size() == RecordsPerBatch && !m_records->push(std::exchange(batch, {})))
+            throw AnalysisCancelled();
     }
+
+    if (!batch.empty() && !m_records->push(std::move(batch)))
+        throw AnalysisCancelled();
+}
+
+void CFStringAnalyzer::run()
+{
+    withLayout([this](auto layout) {
+        analyzeCFStrings<decltype(layout)>();
+    });
 }
@@ -15,6 +15,9 @@ namespace ObjectiveNinja {
  * Basic analyzer for identifying and recording CFString instances.
  */
 class CFStringAnalyzer : public Analyzer {
+    template <typename Layout>
+    void analyzeCFStrings();
+
 public:
     CFStringAnalyzer(SharedAnalysisInfo, SharedAbstractFile);
 
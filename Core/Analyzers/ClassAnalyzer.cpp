@@ -7,81 +7,161 @@
 
 #include "ClassAnalyzer.h"
 
+#include "../ThreadPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <unordered_set>
+
 using namespace ObjectiveNinja;
 
+/**
+ * Number of class list entries per shard. Small enough that large class lists
+ * balance well across workers, large enough to amortize per-shard overhead.
+ */
+constexpr size_t ClassesPerShard = 256;
+
 ClassAnalyzer::ClassAnalyzer(SharedAnalysisInfo info,
     SharedAbstractFile file)
     : Analyzer(std::move(info), std::move(file))
+    , m_cache(std::make_shared<ParseCache>())
 {
 }
 
-MethodListInfo ClassAnalyzer::analyzeMethodList(uint64_t address)
+void ClassAnalyzer::recordMethodImpls(const MethodListInfo& mli)
 {
-    MethodListInfo mli;
-    mli.address = address;
-    mli.flags = m_file->readInt(mli.address);
+    for (const auto& mi : mli.methods)
+        m_methodImpls.emplace_back(mi.nameAddress, mi.implAddress);
+}
 
-    auto methodCount = m_file->readInt(mli.address + 0x4);
-    auto methodSize = mli.hasRelativeOffsets() ? 12 : 24;
+template <typename T, typename Parse>
+std::shared_ptr<const T> ClassAnalyzer::cachedList(std::unordered_map<uint64_t, std::weak_ptr<const T>>& entries,
+    uint64_t address, Parse&& parse)
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_cache->mutex);
+        if (auto it = entries.find(address); it != entries.end())
+            if (auto list = it->second.lock())
+                return list;
+    }
 
-    for (unsigned i = 0; i < methodCount; ++i) {
-        MethodInfo mi;
-        mi.address = mli.address + 8 + (i * methodSize);
+    std::shared_ptr<const T> result = parse();
+
+    std::scoped_lock<std::mutex> lock(m_cache->mutex);
+    auto& entry = entries[address];
+    if (auto existing = entry.lock())
+        return existing;
+
+    entry = result;
+    return result;
+}
+
+template <typename Layout>
+std::shared_ptr<const MethodListInfo> ClassAnalyzer::methodListAt(uint64_t address)
+{
+    auto mli = cachedList(m_cache->methodLists, address, [&] {
+        return std::make_shared<const MethodListInfo>(analyzeMethodList<Layout>(address));
+    });
+
+    // Implementations are recorded for every reference rather than once per
+    // parse, so the final method implementation map does not depend on which
+    // shard parsed a shared list first.
+    recordMethodImpls(*mli);
+    return mli;
+}
+
+template <typename Layout>
+std::shared_ptr<const IvarListInfo> ClassAnalyzer::ivarListAt(uint64_t address)
+{
+    return cachedList(m_cache->ivarLists, address, [&] {
+        return std::make_shared<const IvarListInfo>(analyzeIvarList<Layout>(address));
+    });
+}
+
+template <typename List>
+void ClassAnalyzer::decodeMethodEntries(MethodListInfo& mli, uint64_t entriesAddress, uint32_t count)
+{
+    using Entry = typename List::Entry;
 
-        m_file->seek(mi.address);
+    // The whole list is read in a single call; individual entries are then
+    // decoded from the local copy.
+    auto entries = m_file->readArray<Entry>(entriesAddress, count);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        MethodInfo mi;
+        mi.address = entriesAddress + (i * sizeof(Entry));
 
-        if (mli.hasRelativeOffsets()) {
-            mi.nameAddress = mi.address + static_cast<int32_t>(m_file->readInt());
-            mi.typeAddress = mi.address + 4 + static_cast<int32_t>(m_file->readInt());
-            mi.implAddress = mi.address + 8 + static_cast<int32_t>(m_file->readInt());
+        if constexpr (List::IsRelative) {
+            mi.nameAddress = mi.address + offsetof(Entry, name) + entries[i].name;
+            mi.typeAddress = mi.address + offsetof(Entry, types) + entries[i].types;
+            mi.implAddress = mi.address + offsetof(Entry, imp) + entries[i].imp;
         } else {
-            mi.nameAddress = arp(m_file->readLong());
-            mi.typeAddress = arp(m_file->readLong());
-            mi.implAddress = arp(m_file->readLong());
+            mi.nameAddress = arp(mi.address + offsetof(Entry, name), entries[i].name);
+            mi.typeAddress = arp(mi.address + offsetof(Entry, types), entries[i].types);
+            mi.implAddress = arp(mi.address + offsetof(Entry, imp), entries[i].imp);
         }
 
+        mli.methods.emplace_back(mi);
+    }
+}
+
+template <typename Layout>
+MethodListInfo ClassAnalyzer::analyzeMethodList(uint64_t address)
+{
+    MethodListInfo mli;
+    mli.address = address;
+
+    auto header = m_file->readStruct<ABI::ListHeader>(mli.address);
+    mli.flags = header.flags;
+    mli.methods.reserve(header.count);
+
+    auto entriesAddress = mli.address + sizeof(ABI::ListHeader);
+    if (mli.hasRelativeOffsets())
+        decodeMethodEntries<ABI::RelativeMethodList>(mli, entriesAddress, header.count);
+    else
+        decodeMethodEntries<ABI::AbsoluteMethodList<Layout>>(mli, entriesAddress, header.count);
+
+    for (auto& mi : mli.methods) {
         if (!mli.hasRelativeOffsets() || mli.hasDirectSelectors()) {
-            mi.selector = m_file->readStringAt(mi.nameAddress);
+            mi.selector = readStringAt(mi.nameAddress);
         } else {
-            auto selectorNamePointer = arp(m_file->readLong(mi.nameAddress));
-            mi.selector = m_file->readStringAt(selectorNamePointer);
+            auto selectorNamePointer = arp(mi.nameAddress, m_file->readStruct<typename Layout::Pointer>(mi.nameAddress));
+            mi.selector = readStringAt(selectorNamePointer);
         }
 
-        mi.type = m_file->readStringAt(mi.typeAddress);
-
-        m_info->methodImpls[mi.nameAddress] = mi.implAddress;
-
-        mli.methods.emplace_back(mi);
+        mi.type = readStringAt(mi.typeAddress);
     }
 
     return mli;
 }
 
+template <typename Layout>
 IvarListInfo ClassAnalyzer::analyzeIvarList(uint64_t address)
 {
+    using Entry = typename Layout::Ivar;
+
     IvarListInfo ili;
     ili.address = address;
-    auto ivarCount = m_file->readInt(ili.address + 4);
-
-    ili.ivars.reserve(ivarCount);
 
-    auto ivarSize = 32; // (Pointer Size * 3) + 8
+    auto header = m_file->readStruct<ABI::ListHeader>(ili.address);
+    ili.count = header.count;
+    ili.ivars.reserve(header.count);
 
-    for (unsigned i = 0; i < ivarCount; ++i) {
+    auto entriesAddress = ili.address + sizeof(ABI::ListHeader);
+    auto entries = m_file->readArray<Entry>(entriesAddress, header.count);
+    for (size_t i = 0; i < entries.size(); ++i) {
         IvarInfo ii;
-        ii.address = ili.address + 8 + (i * ivarSize);
-
-        m_file->seek(ii.address);
+        ii.address = entriesAddress + (i * sizeof(Entry));
 
-        ii.offsetAddress = arp(m_file->readLong());
-        ii.nameAddress = arp(m_file->readLong());
-        ii.typeAddress = arp(m_file->readLong());
-        m_file->readInt();
-        ii.size = m_file->readInt();
+        ii.offsetAddress = arp(ii.address + offsetof(Entry, offset), entries[i].offset);
+        ii.nameAddress = arp(ii.address + offsetof(Entry, name), entries[i].name);
+        ii.typeAddress = arp(ii.address + offsetof(Entry, type), entries[i].type);
+        ii.size = entries[i].size;
 
         ii.offset = m_file->readInt(ii.offsetAddress);
-        ii.name = m_file->readStringAt(ii.nameAddress);
-        ii.type = m_file->readStringAt(ii.typeAddress);
+        ii.name = readStringAt(ii.nameAddress);
+        ii.type = readStringAt(ii.typeAddress);
 
         ili.ivars.push_back(ii);
     }
@@ -89,76 +169,272 @@ IvarListInfo ClassAnalyzer::analyzeIvarList(uint64_t address)
     return ili;
 }
 
+template <typename Layout>
 MetaClassInfo* ClassAnalyzer::analyzeISAPointer(uint64_t isaPointer)
 {
-    uint64_t address = m_file->readLong(isaPointer);
+    uint64_t address = fixedUp(isaPointer, m_file->readStruct<typename Layout::Pointer>(isaPointer));
 
     // Check if this pointer is valid and doesn't point to extern or unmapped data (dsc).
-    if (address != 0 && m_file->addressIsMapped(address, false))
+    if (address == 0 || !m_file->addressIsMapped(address, false))
+        return nullptr;
+
     {
-        MetaClassInfo* info = new MetaClassInfo;
+        std::scoped_lock<std::mutex> lock(m_cache->mutex);
+        if (auto it = m_cache->metaClasses.find(address); it != m_cache->metaClasses.end())
+            return it->second;
+    }
+
+    auto mci = analyzeMetaClass<Layout>(isaPointer, address);
 
-        ClassInfo ci;
-        ci.listPointer = isaPointer;
-        ci.address = address;
-        ci.dataAddress = arp(m_file->readLong(ci.address + 0x20));
+    // If another worker stored the same metaclass first, use theirs and drop
+    // this one.
+    std::scoped_lock<std::mutex> lock(m_cache->mutex);
+    auto [it, inserted] = m_cache->metaClasses.try_emplace(address, mci.get());
+    if (inserted)
+        m_info->metaClasses.emplace_back(std::move(mci));
 
-        // Sometimes the lower two bits of the data address are used as flags
-        // for Swift/Objective-C classes. They should be ignored, unless you
-        // want incorrect analysis...
-        ci.dataAddress &= ~ABI::FastPointerDataMask;
+    return it->second;
+}
+
+template <typename Layout>
+std::unique_ptr<MetaClassInfo> ClassAnalyzer::analyzeMetaClass(uint64_t isaPointer, uint64_t address)
+{
+    auto info = std::make_unique<MetaClassInfo>();
 
-        ci.nameAddress = arp(m_file->readLong(ci.dataAddress + 0x18));
-        ci.name = m_file->readStringAt(ci.nameAddress);
+    ClassInfo ci;
+    ci.listPointer = isaPointer;
+    ci.address = address;
+    ci.dataAddress = arp(ci.address + offsetof(typename Layout::Class, data),
+        m_file->readStruct<typename Layout::Class>(ci.address).data);
 
-        ci.methodListAddress = arp(m_file->readLong(ci.dataAddress + 0x20));
-        if (ci.methodListAddress)
-            ci.methodList = analyzeMethodList(ci.methodListAddress);
+    // Sometimes the lower two bits of the data address are used as flags
+    // for Swift/Objective-C classes. They should be ignored, unless you
+    // want incorrect analysis...
+    ci.dataAddress &= ~ABI::FastPointerDataMask;
 
-        ci.isMetaClass = true;
+    auto ro = m_file->readStruct<typename Layout::ClassRO>(ci.dataAddress);
+    ci.nameAddress = arp(ci.dataAddress + offsetof(typename Layout::ClassRO, name), ro.name);
+    ci.name = readStringAt(ci.nameAddress);
 
-        info->info = ci;
-        info->name = ci.name;
-        info->imported = false;
-        return info;
+    // The method list itself is parsed by resolveMethodLists().
+    ci.methodListAddress = arp(ci.dataAddress + offsetof(typename Layout::ClassRO, baseMethods), ro.baseMethods);
+
+    ci.isMetaClass = true;
+
+    info->info = ci;
+    info->name = ci.name;
+    info->imported = false;
+    return info;
+}
+
+template <typename Layout>
+ClassInfo ClassAnalyzer::analyzeClass(uint64_t listPointer, uint64_t classAddress)
+{
+    ClassInfo ci;
+    ci.listPointer = listPointer;
+    ci.address = classAddress;
+    ci.dataAddress = arp(ci.address + offsetof(typename Layout::Class, data),
+        m_file->readStruct<typename Layout::Class>(ci.address).data);
+
+    ci.metaClassInfo = analyzeISAPointer<Layout>(ci.address);
+
+    // Sometimes the lower two bits of the data address are used as flags
+    // for Swift/Objective-C classes. They should be ignored, unless you
+    // want incorrect analysis...
+    ci.dataAddress &= ~ABI::FastPointerDataMask;
+
+    auto ro = m_file->readStruct<typename Layout::ClassRO>(ci.dataAddress);
+    ci.nameAddress = arp(ci.dataAddress + offsetof(typename Layout::ClassRO, name), ro.name);
+    ci.name = readStringAt(ci.nameAddress);
+
+    // The method list itself is parsed by resolveMethodLists().
+    ci.methodListAddress = arp(ci.dataAddress + offsetof(typename Layout::ClassRO, baseMethods), ro.baseMethods);
+
+    ci.ivarListAddress = arp(ci.dataAddress + offsetof(typename Layout::ClassRO, ivars), ro.ivars);
+    if (ci.ivarListAddress)
+        ci.ivarList = ivarListAt<Layout>(ci.ivarListAddress);
+
+    ci.isMetaClass = false;
+    return ci;
+}
+
+template <typename Layout>
+void ClassAnalyzer::resolveMethodLists(ClassInfo& ci)
+{
+    // The metaclass's list goes first, so implementations are recorded in the
+    // same order as when classes were analyzed in a single pass.
+    if (ci.metaClassInfo && ci.metaClassInfo->info.methodListAddress) {
+        auto& meta = ci.metaClassInfo->info;
+        auto mli = methodListAt<Layout>(meta.methodListAddress);
+
+        // Metaclasses may be shared between classes in different shards.
+        std::scoped_lock<std::mutex> lock(m_cache->mutex);
+        if (!meta.methodList)
+            meta.methodList = std::move(mli);
     }
 
-    return nullptr;
+    if (ci.methodListAddress)
+        ci.methodList = methodListAt<Layout>(ci.methodListAddress);
 }
 
-void ClassAnalyzer::run()
+template <typename Fn>
+std::vector<ClassAnalyzer::Shard> ClassAnalyzer::runSharded(size_t count, Fn&& fn)
 {
+    const auto shardCount = (count + ClassesPerShard - 1) / ClassesPerShard;
+    std::vector<Shard> shards(shardCount);
+
+    auto runShard = [&](ClassAnalyzer& worker, size_t i) {
+        fn(worker, i * ClassesPerShard, std::min(count, (i + 1) * ClassesPerShard), shards[i]);
+
+        shards[i].methodImpls = std::move(worker.m_methodImpls);
+        worker.m_methodImpls.clear();
+    };
+
+    if (!m_pool || shardCount <= 1) {
+        for (size_t i = 0; i < shardCount; ++i)
+            runShard(*this, i);
+
+        return shards;
+    }
+
+    // Shards are stolen between workers as they finish, so each worker
+    // lazily gets its own analyzer (and reader) the first time it picks
+    // one up. The last slot belongs to the calling thread.
+    std::vector<std::unique_ptr<ClassAnalyzer>> workers(m_pool->workerCount() + 1);
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(shardCount);
+
+    for (size_t i = 0; i < shardCount; ++i) {
+        tasks.emplace_back([this, &workers, &runShard, i] {
+            auto& worker = workers[m_pool->currentWorkerIndex()];
+            if (!worker) {
+                worker = std::make_unique<ClassAnalyzer>(m_info, m_file->clone());
+                worker->m_cache = m_cache;
+            }
+
+            runShard(*worker, i);
+        });
+    }
+
+    m_pool->runAll(std::move(tasks));
+    return shards;
+}
+
+void ClassAnalyzer::mergeMethodImpls(const std::vector<Shard>& shards)
+{
+    size_t total = m_info->methodImpls.size();
+    for (const auto& shard : shards)
+        total += shard.methodImpls.size();
+    m_info->methodImpls.reserve(total);
+
+    // Shards are merged in class list order, so the result is identical to
+    // analyzing the list serially; later implementations overwrite earlier
+    // ones.
+    for (const auto& shard : shards)
+        for (const auto& [name, impl] : shard.methodImpls)
+            m_info->methodImpls[name] = impl;
+}
+
+template <typename Layout>
+void ClassAnalyzer::analyzeClasses()
+{
+    using Pointer = typename Layout::Pointer;
+
     const auto sectionStart = m_file->sectionStart("__objc_classlist");
     const auto sectionEnd = m_file->sectionEnd("__objc_classlist");
     if (sectionStart == 0 || sectionEnd == 0)
         return;
 
-    for (auto address = sectionStart; address < sectionEnd; address += 8) {
-        ClassInfo ci;
-        ci.listPointer = address;
-        ci.address = arp(m_file->readLong(address));
-        ci.dataAddress = arp(m_file->readLong(ci.address + 0x20));
+    const auto entries = arp(m_file->readArray<Pointer>(sectionStart, (sectionEnd - sectionStart) / sizeof(Pointer)), sectionStart);
+    const bool resolveMethods = !m_options.lazyMethodLists;
 
-        ci.metaClassInfo = analyzeISAPointer(ci.address);
+    // Deferred method lists are resolved from the stored classes, so classes
+    // are stored even when streaming in that case.
+    const bool storeClasses = !m_records || !resolveMethods;
 
-        // Sometimes the lower two bits of the data address are used as flags
-        // for Swift/Objective-C classes. They should be ignored, unless you
-        // want incorrect analysis...
-        ci.dataAddress &= ~ABI::FastPointerDataMask;
+    auto shards = runSharded(entries.size(), [&](ClassAnalyzer& worker, size_t begin, size_t end, Shard& shard) {
+        // Once the consumer has stopped taking records, the remaining shards
+        // are skipped.
+        if (m_records && m_records->closed())
+            return;
 
-        ci.nameAddress = arp(m_file->readLong(ci.dataAddress + 0x18));
-        ci.name = m_file->readStringAt(ci.nameAddress);
+        shard.classes.reserve(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+            auto ci = worker.analyzeClass<Layout>(sectionStart + i * sizeof(Pointer), entries[i]);
+            if (resolveMethods)
+                worker.resolveMethodLists<Layout>(ci);
 
-        ci.methodListAddress = arp(m_file->readLong(ci.dataAddress + 0x20));
-        if (ci.methodListAddress)
-            ci.methodList = analyzeMethodList(ci.methodListAddress);
+            if (ci.metaClassInfo)
+                shard.metaClassRefs.emplace_back(ci.metaClassInfo, ci.address);
 
+            shard.classes.emplace_back(std::move(ci));
+        }
 
-        ci.ivarListAddress = arp(m_file->readLong(ci.dataAddress + 0x30));
-        if (ci.ivarListAddress)
-            ci.ivarList = analyzeIvarList(ci.ivarListAddress);
+        // When streaming, each shard is sent as soon as it is done; the
+        // consumer does not depend on class list order.
+        if (m_records) {
+            std::vector<AnalysisRecord> batch(shard.classes.begin(), shard.classes.end());
+            if (!m_records->push(std::move(batch)))
+                return;
 
-        ci.isMetaClass = false;
-        m_info->classes.emplace_back(ci);
-    }
+            if (!storeClasses)
+                shard.classes = {};
+        }
+    });
+
+    if (m_records && m_records->closed())
+        throw AnalysisCancelled();
+
+    m_info->classes.reserve(m_info->classes.size() + entries.size());
+    for (auto& shard : shards)
+        for (auto& ci : shard.classes)
+            m_info->classes.emplace_back(std::move(ci));
+
+    mergeMethodImpls(shards);
+
+    // A shared metaclass keeps the ISA pointer of whichever class reached it
+    // first; make that the first class in list order regardless of which
+    // shard happened to parse it. This goes through the shards rather than
+    // the stored classes, which are empty when streaming.
+    std::unordered_set<const MetaClassInfo*> seenMetaClasses;
+    for (const auto& shard : shards)
+        for (const auto& [mci, address] : shard.metaClassRefs)
+            if (seenMetaClasses.insert(mci).second)
+                mci->info.listPointer = address;
+
+    if (resolveMethods)
+        return;
+
+    // Method lists are resolved later by a fresh analyzer, on a pool of its
+    // own, since this analyzer and its pool will be gone by then.
+    m_info->deferMethods([options = m_options](SharedAnalysisInfo info, SharedAbstractFile file) {
+        ThreadPool pool(options.workerCount);
+
+        ClassAnalyzer analyzer(info, file);
+        analyzer.setThreadPool(&pool);
+        analyzer.setOptions(options);
+        analyzer.withLayout([&](auto layout) {
+            analyzer.resolveDeferredMethodLists<decltype(layout)>();
+        });
+    });
+}
+
+template <typename Layout>
+void ClassAnalyzer::resolveDeferredMethodLists()
+{
+    auto& classes = m_info->classes;
+    auto shards = runSharded(classes.size(), [&](ClassAnalyzer& worker, size_t begin, size_t end, Shard&) {
+        for (size_t i = begin; i < end; ++i)
+            worker.resolveMethodLists<Layout>(classes[i]);
+    });
+
+    mergeMethodImpls(shards);
+    m_info->buildDispatchIndex();
+}
+
+void ClassAnalyzer::run()
+{
+    withLayout([this](auto layout) {
+        analyzeClasses<decltype(layout)>();
+    });
 }
@@ -9,23 +9,150 @@
 
 #include "../Analyzer.h"
 
+#include <mutex>
+#include <unordered_map>
+
 namespace ObjectiveNinja {
 
 /**
  * Analyzer for extracting Objective-C class information.
  */
 class ClassAnalyzer : public Analyzer {
+    /**
+     * Results for a contiguous range of the class list.
+     */
+    struct Shard {
+        std::vector<ClassInfo> classes;
+        std::vector<std::pair<uint64_t, uint64_t>> methodImpls;
+
+        /**
+         * Metaclass of each class in the range, paired with the class's
+         * address. Kept even if the classes themselves are not.
+         */
+        std::vector<std::pair<MetaClassInfo*, uint64_t>> metaClassRefs;
+    };
+
+    /**
+     * Parsed lists and metaclasses for the current run, keyed by address.
+     * Shared between the analyzers working on different shards.
+     *
+     * Lists are only referenced weakly, so that when classes are streamed,
+     * lists are freed once the consumer is done with them. A list that is
+     * referenced again after that is simply parsed again.
+     */
+    struct ParseCache {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::weak_ptr<const MethodListInfo>> methodLists;
+        std::unordered_map<uint64_t, std::weak_ptr<const IvarListInfo>> ivarLists;
+        std::unordered_map<uint64_t, MetaClassInfo*> metaClasses;
+    };
+
+    std::shared_ptr<ParseCache> m_cache;
+
+    /**
+     * Method implementations found by this analyzer since the last shard was
+     * finished, in discovery order.
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> m_methodImpls;
+
+    /**
+     * Get the cached list for an address if it is still alive, or create it
+     * with `parse` and add it to the cache.
+     */
+    template <typename T, typename Parse>
+    std::shared_ptr<const T> cachedList(std::unordered_map<uint64_t, std::weak_ptr<const T>>& entries,
+        uint64_t address, Parse&& parse);
+
+    /**
+     * Record the implementations of a method list's methods.
+     */
+    void recordMethodImpls(const MethodListInfo&);
+
+    /**
+     * Analyze a method list, or get the cached result for its address.
+     */
+    template <typename Layout>
+    std::shared_ptr<const MethodListInfo> methodListAt(uint64_t);
+
     /**
      * Analyze a method list.
      */
+    template <typename Layout>
     MethodListInfo analyzeMethodList(uint64_t);
 
+    /**
+     * Decode the entries of a method list, specialized for either absolute or
+     * relative method lists.
+     */
+    template <typename List>
+    void decodeMethodEntries(MethodListInfo&, uint64_t entriesAddress, uint32_t count);
+
+    /**
+     * Analyze an ivar list, or get the cached result for its address.
+     */
+    template <typename Layout>
+    std::shared_ptr<const IvarListInfo> ivarListAt(uint64_t);
+
     /**
      * Analyze an ivar list.
      */
+    template <typename Layout>
     IvarListInfo analyzeIvarList(uint64_t);
+
+    /**
+     * Analyze the metaclass pointed to by a class's ISA pointer, or get the
+     * cached result for the metaclass's address. Metaclasses are owned by
+     * the analysis info. The cache is not locked while parsing; if two
+     * workers race on the same metaclass, the first result stored is used.
+     */
+    template <typename Layout>
     MetaClassInfo* analyzeISAPointer(uint64_t);
 
+    template <typename Layout>
+    std::unique_ptr<MetaClassInfo> analyzeMetaClass(uint64_t isaPointer, uint64_t address);
+
+    /**
+     * Analyze the class at the given (decoded) address, referenced by the
+     * given class list entry.
+     */
+    template <typename Layout>
+    ClassInfo analyzeClass(uint64_t listPointer, uint64_t classAddress);
+
+    /**
+     * Parse the method lists of a class and its metaclass, recording their
+     * implementations.
+     */
+    template <typename Layout>
+    void resolveMethodLists(ClassInfo&);
+
+    /**
+     * Split [0, count) into shards and call `fn(worker, begin, end, shard)`
+     * for each, across the thread pool if one is available. Every worker has
+     * its own reader; method implementations recorded by the worker are
+     * collected into the shard.
+     */
+    template <typename Fn>
+    std::vector<Shard> runSharded(size_t count, Fn&& fn);
+
+    /**
+     * Apply the method implementations of all shards, in shard order.
+     */
+    void mergeMethodImpls(const std::vector<Shard>&);
+
+    /**
+     * Analyze all classes in the class list, splitting the list into shards
+     * across the thread pool if one is available. If lazy method lists are
+     * enabled, parsing method lists is deferred.
+     */
+    template <typename Layout>
+    void analyzeClasses();
+
+    /**
+     * Parse the method lists of all previously analyzed classes.
+     */
+    template <typename Layout>
+    void resolveDeferredMethodLists();
+
 public:
     ClassAnalyzer(SharedAnalysisInfo, SharedAbstractFile);
 
@@ -7,24 +7,55 @@ ClassRefAnalyzer::ClassRefAnalyzer(SharedAnalysisInfo info, SharedAbstractFile f
 {
 }
 
-void ClassRefAnalyzer::run()
+std::string_view ClassRefAnalyzer::importedClassName(uint64_t address, uint64_t targetAddress)
 {
-    const auto sectionStart = m_file->sectionStart("__objc_classrefs");
-    const auto sectionEnd = m_file->sectionEnd("__objc_classrefs");
-
-    // TODO: Dynamic Address size for armv7
-    if (sectionStart != 0 && sectionEnd != 0) {
-        for (auto address = sectionStart; address < sectionEnd; address += 0x8) {
-            m_info->classRefs.push_back({ address, m_file->readLong(address) });
-        }
+    constexpr std::string_view ClassPrefix = "_OBJC_CLASS_$_";
+
+    for (auto location : { address, targetAddress }) {
+        if (!location || !m_file->hasImportedSymbolAtLocation(location))
+            continue;
+
+        auto name = m_file->symbolNameAtLocation(location);
+        if (name.compare(0, ClassPrefix.size(), ClassPrefix) == 0)
+            name.erase(0, ClassPrefix.size());
+
+        return m_info->strings.intern(name);
     }
 
-    const auto superRefSectionStart = m_file->sectionStart("__objc_superrefs");
-    const auto superRefSectionEnd = m_file->sectionEnd("__objc_superrefs");
+    return {};
+}
+
+template <typename Layout>
+void ClassRefAnalyzer::analyzeRefSection(const std::string& sectionName, std::vector<ClassRefInfo>& refs)
+{
+    using Pointer = typename Layout::Pointer;
+
+    const auto sectionStart = m_file->sectionStart(sectionName);
+    const auto sectionEnd = m_file->sectionEnd(sectionName);
+    if (sectionStart == 0 || sectionEnd == 0)
+        return;
+
+    const auto referencedAddresses = m_file->readArray<Pointer>(sectionStart, (sectionEnd - sectionStart) / sizeof(Pointer));
+    const auto targetAddresses = arp(referencedAddresses, sectionStart);
+    refs.reserve(refs.size() + referencedAddresses.size());
 
-    if (superRefSectionStart != 0 && superRefSectionEnd != 0) {
-        for (auto address = superRefSectionStart; address < superRefSectionEnd; address += 0x8) {
-            m_info->superRefs.push_back({ address, m_file->readLong(address) });
-        }
+    for (size_t i = 0; i < referencedAddresses.size(); ++i) {
+        auto address = sectionStart + i * sizeof(Pointer);
+        refs.push_back({ address, fixedUp(address, referencedAddresses[i]),
+            importedClassName(address, targetAddresses[i]) });
     }
-}
\ No newline at end of file
+}
+
+template <typename Layout>
+void ClassRefAnalyzer::analyzeClassRefs()
+{
+    analyzeRefSection<Layout>("__objc_classrefs", m_info->classRefs);
+    analyzeRefSection<Layout>("__objc_superrefs", m_info->superRefs);
+}
+
+void ClassRefAnalyzer::run()
+{
+    withLayout([this](auto layout) {
+        analyzeClassRefs<decltype(layout)>();
+    });
+}
@@ -8,6 +8,21 @@ namespace ObjectiveNinja {
  * Analyzer for extracting Objective-C class information.
  */
 class ClassRefAnalyzer : public Analyzer {
+    /**
+     * Get the name of the imported class a reference points to, if any. Both
+     * the reference itself and its (decoded) target are checked for an
+     * imported symbol.
+     */
+    std::string_view importedClassName(uint64_t address, uint64_t targetAddress);
+
+    /**
+     * Analyze all references in the given section, appending them to `refs`.
+     */
+    template <typename Layout>
+    void analyzeRefSection(const std::string& sectionName, std::vector<ClassRefInfo>& refs);
+
+    template <typename Layout>
+    void analyzeClassRefs();
 
 public:
     ClassRefAnalyzer(SharedAnalysisInfo, SharedAbstractFile);
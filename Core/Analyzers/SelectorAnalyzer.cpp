@@ -15,23 +15,31 @@ SelectorAnalyzer::SelectorAnalyzer(SharedAnalysisInfo info,
 {
 }
 
-void SelectorAnalyzer::run()
+template <typename Layout>
+void SelectorAnalyzer::analyzeSelectorRefs()
 {
+    using Pointer = typename Layout::Pointer;
+
     const auto sectionStart = m_file->sectionStart("__objc_selrefs");
     const auto sectionEnd = m_file->sectionEnd("__objc_selrefs");
     if (sectionStart == 0 || sectionEnd == 0)
         return;
 
-    for (auto address = sectionStart; address < sectionEnd; address += 0x8) {
-        auto ssri = std::make_shared<SelectorRefInfo>();
-        ssri->address = address;
-        ssri->rawSelector = m_file->readLong(address);
-        ssri->nameAddress = arp(ssri->rawSelector);
-        ssri->name = m_file->readStringAt(ssri->nameAddress);
+    const auto rawSelectors = m_file->readArray<Pointer>(sectionStart, (sectionEnd - sectionStart) / sizeof(Pointer));
+    const auto nameAddresses = arp(rawSelectors, sectionStart);
+    m_info->selectorRefs.reserve(rawSelectors.size());
 
-        m_info->selectorRefs.emplace_back(ssri);
-
-        m_info->selectorRefsByKey[ssri->rawSelector] = ssri;
-        m_info->selectorRefsByKey[ssri->address] = ssri;
+    for (size_t i = 0; i < rawSelectors.size(); ++i) {
+        m_info->selectorRefs.add(sectionStart + i * sizeof(Pointer), rawSelectors[i],
+            nameAddresses[i], readStringAt(nameAddresses[i]));
     }
+
+    m_info->selectorRefs.buildIndices();
+}
+
+void SelectorAnalyzer::run()
+{
+    withLayout([this](auto layout) {
+        analyzeSelectorRefs<decltype(layout)>();
+    });
 }
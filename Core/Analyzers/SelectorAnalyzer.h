@@ -15,6 +15,9 @@ namespace ObjectiveNinja {
  * Analyzer for parsing Objective-C selectors and selector references.
  */
 class SelectorAnalyzer : public Analyzer {
+    template <typename Layout>
+    void analyzeSelectorRefs();
+
 public:
     SelectorAnalyzer(SharedAnalysisInfo, SharedAbstractFile);
 
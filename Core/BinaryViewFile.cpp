@@ -7,32 +7,250 @@
 
 #include "BinaryViewFile.h"
 
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
 namespace ObjectiveNinja {
 
-BinaryViewFile::BinaryViewFile(BinaryViewRef bv)
+/**
+ * Notification listener that marks the section table stale whenever the
+ * view's segments or sections change.
+ */
+class BinaryViewFile::LayoutObserver : public BinaryNinja::BinaryDataNotification {
+    std::shared_ptr<std::atomic<bool>> m_changed;
+
+public:
+    explicit LayoutObserver(std::shared_ptr<std::atomic<bool>> changed)
+        : m_changed(std::move(changed))
+    {
+    }
+
+    void OnSegmentAdded(BinaryNinja::BinaryView*, BinaryNinja::Segment*) override { *m_changed = true; }
+    void OnSegmentRemoved(BinaryNinja::BinaryView*, BinaryNinja::Segment*) override { *m_changed = true; }
+    void OnSegmentUpdated(BinaryNinja::BinaryView*, BinaryNinja::Segment*) override { *m_changed = true; }
+    void OnSectionAdded(BinaryNinja::BinaryView*, BinaryNinja::Section*) override { *m_changed = true; }
+    void OnSectionRemoved(BinaryNinja::BinaryView*, BinaryNinja::Section*) override { *m_changed = true; }
+    void OnSectionUpdated(BinaryNinja::BinaryView*, BinaryNinja::Section*) override { *m_changed = true; }
+};
+
+const std::vector<std::string> BinaryViewFile::CachedSections = {
+    "__objc_classlist",
+    "__objc_classrefs",
+    "__objc_superrefs",
+    "__objc_selrefs",
+    "__objc_const",
+    "__objc_data",
+    "__objc_methlist",
+    "__objc_methname",
+    "__objc_methtype",
+    "__objc_classname",
+    "__cfstring",
+};
+
+BinaryViewFile::BinaryViewFile(BinaryViewRef bv, bool cacheSections, std::string imageName)
     : m_bv(bv)
+    , m_imageName(std::move(imageName))
     , m_reader(BinaryNinja::BinaryReader(bv))
+    , m_retiredCacheCounters(std::make_shared<RetiredCacheCounters>())
+    , m_layoutChanged(std::make_shared<std::atomic<bool>>(true))
+    , m_layoutObserver(std::make_unique<LayoutObserver>(m_layoutChanged))
+{
+    m_bv->RegisterNotification(m_layoutObserver.get());
+    sectionTable();
+
+    // Cached data is decoded in host byte order, so the cache is only usable
+    // for little-endian views.
+    if (cacheSections && m_bv->GetDefaultEndianness() == LittleEndian)
+        populateCache();
+}
+
+BinaryViewFile::~BinaryViewFile()
+{
+    m_bv->UnregisterNotification(m_layoutObserver.get());
+
+    m_retiredCacheCounters->hits.fetch_add(m_cacheHits, std::memory_order_relaxed);
+    m_retiredCacheCounters->misses.fetch_add(m_cacheMisses, std::memory_order_relaxed);
+}
+
+std::shared_ptr<AbstractFile> BinaryViewFile::clone() const
+{
+    auto result = std::make_shared<BinaryViewFile>(m_bv, false, m_imageName);
+    result->m_cache = m_cache;
+    result->m_retiredCacheCounters = m_retiredCacheCounters;
+
+    if (m_importedSymbolsIndexed) {
+        result->m_importedSymbols = m_importedSymbols;
+        result->m_importedSymbolsIndexed = true;
+    }
+
+    return result;
+}
+
+const BinaryViewFile::SectionTable& BinaryViewFile::sectionTable() const
 {
+    if (!m_layoutChanged->exchange(false))
+        return m_sectionTable;
+
+    const auto imagePrefix = m_imageName.empty() ? std::string() : m_imageName + "::";
+
+    SectionTable table;
+    for (const auto& section : m_bv->GetSections()) {
+        AddressRange range = { section->GetStart(), section->GetStart() + section->GetLength() };
+        auto name = section->GetName();
+
+        if (name == ".extern")
+            table.externRanges.push_back(range);
+
+        // Sections of other images are still mapped, but can't be looked up
+        // by name from this one.
+        if (imagePrefix.empty())
+            table.sections[name] = range;
+        else if (name.compare(0, imagePrefix.size(), imagePrefix) == 0)
+            table.sections[name.substr(imagePrefix.size())] = range;
+    }
+
+    for (const auto& segment : m_bv->GetSegments())
+        table.mappedRanges.push_back({ segment->GetStart(), segment->GetEnd() });
+
+    // Views without segments (e.g. raw views) are mapped contiguously.
+    if (table.mappedRanges.empty())
+        table.mappedRanges.push_back({ m_bv->GetStart(), m_bv->GetEnd() });
+
+    const auto byStart = [](const AddressRange& a, const AddressRange& b) {
+        return a.start < b.start;
+    };
+    std::sort(table.externRanges.begin(), table.externRanges.end(), byStart);
+    std::sort(table.mappedRanges.begin(), table.mappedRanges.end(), byStart);
+
+    // Merge overlapping and adjacent segments so each address belongs to at
+    // most one range.
+    std::vector<AddressRange> merged;
+    for (const auto& range : table.mappedRanges) {
+        if (!merged.empty() && range.start <= merged.back().end)
+            merged.back().end = std::max(merged.back().end, range.end);
+        else
+            merged.push_back(range);
+    }
+    table.mappedRanges = std::move(merged);
+
+    m_sectionTable = std::move(table);
+    return m_sectionTable;
+}
+
+void BinaryViewFile::populateCache()
+{
+    m_cache = std::make_shared<SectionCache>();
+
+    const auto& sections = sectionTable().sections;
+    for (const auto& name : CachedSections) {
+        auto it = sections.find(name);
+        if (it == sections.end())
+            continue;
+
+        std::vector<uint8_t> data(it->second.end - it->second.start);
+        data.resize(m_bv->Read(data.data(), it->second.start, data.size()));
+
+        m_cache->add(it->second.start, std::move(data));
+    }
+}
+
+std::vector<std::string> BinaryViewFile::objcImageNames(BinaryViewRef bv)
+{
+    constexpr std::string_view Separator = "::__objc_";
+
+    std::vector<std::string> names;
+    for (const auto& section : bv->GetSections()) {
+        auto name = section->GetName();
+        if (auto position = name.find(Separator); position != std::string::npos && position > 0)
+            names.push_back(name.substr(0, position));
+    }
+
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    return names;
+}
+
+SectionCache::Stats BinaryViewFile::cacheStats() const
+{
+    if (!m_cache)
+        return {};
+
+    return {
+        m_cacheHits + m_retiredCacheCounters->hits.load(std::memory_order_relaxed),
+        m_cacheMisses + m_retiredCacheCounters->misses.load(std::memory_order_relaxed),
+        m_cache->bytes(),
+    };
+}
+
+const uint8_t* BinaryViewFile::cachedData(uint64_t address, size_t length)
+{
+    if (!m_cache)
+        return nullptr;
+
+    auto data = m_cache->find(address, length);
+    if (data)
+        ++m_cacheHits;
+    else
+        ++m_cacheMisses;
+
+    return data;
+}
+
+template <typename T, typename ReadFn>
+T BinaryViewFile::readValue(ReadFn readFn)
+{
+    T result;
+
+    if (auto data = cachedData(m_offset, sizeof(T))) {
+        std::memcpy(&result, data, sizeof(T));
+    } else {
+        m_reader.Seek(m_offset);
+        result = readFn();
+    }
+
+    m_offset += sizeof(T);
+    return result;
 }
 
 void BinaryViewFile::seek(uint64_t address)
 {
-    m_reader.Seek(address);
+    m_offset = address;
+}
+
+uint64_t BinaryViewFile::tell() const
+{
+    return m_offset;
 }
 
 uint8_t BinaryViewFile::readByte()
 {
-    return m_reader.Read8();
+    return readValue<uint8_t>([this] { return m_reader.Read8(); });
 }
 
 uint32_t BinaryViewFile::readInt()
 {
-    return m_reader.Read32();
+    return readValue<uint32_t>([this] { return m_reader.Read32(); });
 }
 
 uint64_t BinaryViewFile::readLong()
 {
-    return m_reader.Read64();
+    return readValue<uint64_t>([this] { return m_reader.Read64(); });
+}
+
+size_t BinaryViewFile::readBytes(uint64_t offset, void* buffer, size_t length)
+{
+    if (auto data = cachedData(offset, length)) {
+        std::memcpy(buffer, data, length);
+        return length;
+    }
+
+    return m_bv->Read(buffer, offset, length);
+}
+
+size_t BinaryViewFile::pointerSize() const
+{
+    return m_bv->GetAddressSize();
 }
 
 uint64_t BinaryViewFile::imageBase() const
@@ -42,52 +260,71 @@ uint64_t BinaryViewFile::imageBase() const
 
 uint64_t BinaryViewFile::sectionStart(const std::string& name) const
 {
-    auto section = m_bv->GetSectionByName(name);
-    if (!section)
+    const auto& sections = sectionTable().sections;
+
+    auto it = sections.find(name);
+    if (it == sections.end())
         return 0;
 
-    return section->GetStart();
+    return it->second.start;
 }
 
 uint64_t BinaryViewFile::sectionEnd(const std::string& name) const
 {
-    auto section = m_bv->GetSectionByName(name);
-    if (!section)
+    const auto& sections = sectionTable().sections;
+
+    auto it = sections.find(name);
+    if (it == sections.end())
         return 0;
 
-    return section->GetStart() + section->GetLength();
+    return it->second.end;
 }
 
 bool BinaryViewFile::addressIsMapped(uint64_t address, bool includeExtern) const
 {
-    if (!includeExtern)
-    {
-        uint64_t externStart = sectionStart(".extern");
-        uint64_t externEnd = sectionEnd(".extern");
-        if (externStart) {
-            if (externStart < address && externEnd > address) {
-                return false;
-            }
-        }
-    }
+    const auto& table = sectionTable();
+    if (!includeExtern && rangesContain(table.externRanges, address))
+        return false;
 
-    return m_bv->IsValidOffset(address);
+    return rangesContain(table.mappedRanges, address);
 }
 
 
-bool BinaryViewFile::hasImportedSymbolAtLocation(uint64_t address) const
+const BinaryViewFile::ImportedSymbol* BinaryViewFile::importedSymbolAt(uint64_t address) const
 {
-    BinaryNinja::Ref<BinaryNinja::Symbol> sym = m_bv->GetSymbolByAddress(address);
+    if (!m_importedSymbolsIndexed) {
+        for (const auto& sym : m_bv->GetSymbolsOfType(ImportedDataSymbol))
+            m_importedSymbols.push_back({ sym->GetAddress(), sym->GetFullName() });
 
-    if (sym)
-        return (sym->GetType() == ImportedDataSymbol);
+        // Keep a single symbol per address.
+        std::stable_sort(m_importedSymbols.begin(), m_importedSymbols.end(),
+            [](const ImportedSymbol& a, const ImportedSymbol& b) { return a.address < b.address; });
+        m_importedSymbols.erase(std::unique(m_importedSymbols.begin(), m_importedSymbols.end(),
+                                    [](const ImportedSymbol& a, const ImportedSymbol& b) { return a.address == b.address; }),
+            m_importedSymbols.end());
+
+        m_importedSymbolsIndexed = true;
+    }
+
+    auto it = std::lower_bound(m_importedSymbols.begin(), m_importedSymbols.end(), address,
+        [](const ImportedSymbol& symbol, uint64_t address) { return symbol.address < address; });
+    if (it == m_importedSymbols.end() || it->address != address)
+        return nullptr;
 
-    return false;
+    return &*it;
+}
+
+bool BinaryViewFile::hasImportedSymbolAtLocation(uint64_t address) const
+{
+    return importedSymbolAt(address) != nullptr;
 }
 
 
 std::string BinaryViewFile::symbolNameAtLocation(uint64_t address) const
 {
+    if (auto imported = importedSymbolAt(address))
+        return imported->name;
+
     BinaryNinja::Ref<BinaryNinja::Symbol> sym = m_bv->GetSymbolByAddress(address);
 
     if (sym)
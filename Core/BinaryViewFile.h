@@ -8,30 +8,156 @@
 #pragma once
 
 #include "AbstractFile.h"
+#include "AddressRange.h"
+#include "SectionCache.h"
 
 #include <binaryninjaapi.h>
 
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 using BinaryViewRef = BinaryNinja::Ref<BinaryNinja::BinaryView>;
 
 namespace ObjectiveNinja {
 
 /**
  * AbstractFile implementation that wraps a BinaryView.
+ *
+ * A file may be scoped to a single image of a dyld shared cache view, whose
+ * sections are named "<image>::<section>"; sections are then looked up by
+ * their name within that image only.
  */
 class BinaryViewFile : public ObjectiveNinja::AbstractFile {
+    /**
+     * Section and segment layout of the view, captured once so lookups don't
+     * need to round-trip through the core.
+     */
+    struct SectionTable {
+        std::unordered_map<std::string, AddressRange> sections;
+
+        /**
+         * Sorted, non-overlapping ranges backed by a segment.
+         */
+        std::vector<AddressRange> mappedRanges;
+
+        /**
+         * Sorted ranges of the synthetic `.extern` section(s).
+         */
+        std::vector<AddressRange> externRanges;
+    };
+
+    struct ImportedSymbol {
+        uint64_t address;
+        std::string name;
+    };
+
+    /**
+     * Section cache hits and misses of clones that have been destroyed,
+     * shared by a file and all of its clones.
+     */
+    struct RetiredCacheCounters {
+        std::atomic<uint64_t> hits { 0 };
+        std::atomic<uint64_t> misses { 0 };
+    };
+
+    class LayoutObserver;
+
     BinaryViewRef m_bv;
+    std::string m_imageName;
     BinaryNinja::BinaryReader m_reader;
+    uint64_t m_offset = 0;
+
+    std::shared_ptr<SectionCache> m_cache;
+
+    /**
+     * Section cache lookups made through this file. Only this file's reader
+     * updates them; they are added to `m_retiredCacheCounters` once it is
+     * destroyed.
+     */
+    uint64_t m_cacheHits = 0;
+    uint64_t m_cacheMisses = 0;
+    std::shared_ptr<RetiredCacheCounters> m_retiredCacheCounters;
+
+    mutable std::vector<ImportedSymbol> m_importedSymbols;
+    mutable bool m_importedSymbolsIndexed = false;
+
+    mutable SectionTable m_sectionTable;
+    std::shared_ptr<std::atomic<bool>> m_layoutChanged;
+    std::unique_ptr<LayoutObserver> m_layoutObserver;
+
+    /**
+     * Get the section table, rebuilding it first if the view's segments or
+     * sections have changed since it was last built.
+     */
+    const SectionTable& sectionTable() const;
+
+    /**
+     * Find the imported symbol at an address, building the sorted index of
+     * all imported data symbols on first use.
+     */
+    const ImportedSymbol* importedSymbolAt(uint64_t) const;
+
+    /**
+     * Snapshot the Objective-C metadata sections into local buffers.
+     */
+    void populateCache();
+
+    /**
+     * Look up `length` bytes at `address` in the section cache, counting
+     * the hit or miss.
+     */
+    const uint8_t* cachedData(uint64_t address, size_t length);
+
+    /**
+     * Read a value at the current offset, preferring the section cache and
+     * falling back to the BinaryReader.
+     */
+    template <typename T, typename ReadFn>
+    T readValue(ReadFn);
 
 public:
-    explicit BinaryViewFile(BinaryViewRef);
-    virtual ~BinaryViewFile() {}
+    /**
+     * Sections copied into the section cache, if enabled.
+     */
+    static const std::vector<std::string> CachedSections;
+
+    /**
+     * Create a file for the given view. If `cacheSections` is true, the
+     * Objective-C metadata sections are snapshotted up front and reads from
+     * them are served from memory. If `imageName` is given, the file is
+     * scoped to that image of a shared cache view.
+     */
+    explicit BinaryViewFile(BinaryViewRef, bool cacheSections = true, std::string imageName = {});
+    virtual ~BinaryViewFile();
+
+    std::shared_ptr<AbstractFile> clone() const override;
+
+    /**
+     * Get the section cache statistics, including the lookups of clones that
+     * have already been destroyed. All counters are zero if the cache is
+     * disabled.
+     */
+    SectionCache::Stats cacheStats() const;
+
+    /**
+     * Get the names of the shared cache images loaded in a view which have
+     * Objective-C metadata sections, in sorted order. Empty for views that
+     * are not shared caches.
+     */
+    static std::vector<std::string> objcImageNames(BinaryViewRef);
 
     void seek(uint64_t) override;
+    uint64_t tell() const override;
 
     uint8_t readByte() override;
     uint32_t readInt() override;
     uint64_t readLong() override;
+    size_t readBytes(uint64_t offset, void* buffer, size_t length) override;
 
+    size_t pointerSize() const override;
     uint64_t imageBase() const override;
     uint64_t sectionStart(const std::string& name) const override;
     uint64_t sectionEnd(const std::string& name) const override;
@@ -0,0 +1,300 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "ChainedFixups.h"
+
+#include "AbstractFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace ObjectiveNinja {
+
+namespace {
+
+struct FixupsHeader {
+    uint32_t version;
+    uint32_t startsOffset;
+    uint32_t importsOffset;
+    uint32_t symbolsOffset;
+    uint32_t importCount;
+    uint32_t importsFormat;
+    uint32_t symbolsFormat;
+};
+
+/**
+ * Fixed part of `dyld_chained_starts_in_segment`; the page starts follow.
+ */
+struct SegmentStarts {
+    uint32_t size;
+    uint16_t pageSize;
+    uint16_t pointerFormat;
+    uint64_t segmentOffset;
+    uint32_t maxValidPointer;
+    uint16_t pageCount;
+};
+
+constexpr size_t SegmentStartsSize = 22;
+
+enum PointerFormat : uint16_t {
+    PointerFormatARM64E = 1,
+    PointerFormat64 = 2,
+    PointerFormat32 = 3,
+    PointerFormat64Offset = 6,
+    PointerFormatARM64EUserland = 9,
+    PointerFormatARM64EUserland24 = 12,
+};
+
+enum ImportFormat : uint32_t {
+    ImportFormatPlain = 1,
+    ImportFormatAddend = 2,
+    ImportFormatAddend64 = 3,
+};
+
+constexpr uint16_t PageStartNone = 0xFFFF;
+constexpr uint16_t PageStartMulti = 0x8000;
+constexpr uint16_t PageStartLast = 0x8000;
+
+/**
+ * Copy a structure out of the payload, throwing if it would run past the end.
+ */
+template <typename T>
+T load(const uint8_t* data, size_t size, uint64_t offset, size_t length = sizeof(T))
+{
+    if (offset > size || size - offset < length)
+        throw std::runtime_error("Truncated chained fixups");
+
+    T result {};
+    std::memcpy(&result, data + offset, length);
+    return result;
+}
+
+/**
+ * A single decoded chain entry.
+ */
+struct ChainEntry {
+    bool isBind;
+    uint64_t value;
+    uint32_t next;
+};
+
+ChainEntry decodeEntry(uint64_t raw, uint16_t format, uint64_t imageBase)
+{
+    switch (format) {
+    case PointerFormatARM64E:
+    case PointerFormatARM64EUserland:
+    case PointerFormatARM64EUserland24: {
+        bool isAuth = raw >> 63;
+        bool isBind = (raw >> 62) & 1;
+        auto next = static_cast<uint32_t>((raw >> 51) & 0x7FF);
+
+        if (isBind)
+            return { true, raw & (format == PointerFormatARM64EUserland24 ? 0xFFFFFF : 0xFFFF), next };
+        if (isAuth)
+            return { false, imageBase + (raw & 0xFFFFFFFF), next };
+
+        // Plain arm64e rebases hold a virtual address; the userland variants
+        // hold an offset from the image base.
+        uint64_t target = raw & 0x7FFFFFFFFFF;
+        if (format != PointerFormatARM64E)
+            target += imageBase;
+
+        return { false, target | (((raw >> 43) & 0xFF) << 56), next };
+    }
+    case PointerFormat64:
+    case PointerFormat64Offset: {
+        auto next = static_cast<uint32_t>((raw >> 51) & 0xFFF);
+        if (raw >> 63)
+            return { true, raw & 0xFFFFFF, next };
+
+        uint64_t target = raw & 0xFFFFFFFFF;
+        if (format == PointerFormat64Offset)
+            target += imageBase;
+
+        return { false, target | (((raw >> 36) & 0xFF) << 56), next };
+    }
+    case PointerFormat32: {
+        auto next = static_cast<uint32_t>((raw >> 26) & 0x1F);
+        if ((raw >> 31) & 1)
+            return { true, raw & 0xFFFFF, next };
+
+        return { false, raw & 0x3FFFFFF, next };
+    }
+    default:
+        throw std::runtime_error("Unsupported chained pointer format");
+    }
+}
+
+/**
+ * Get the distance in bytes between chain entries for the given format.
+ */
+uint32_t chainStride(uint16_t format)
+{
+    switch (format) {
+    case PointerFormatARM64E:
+    case PointerFormatARM64EUserland:
+    case PointerFormatARM64EUserland24:
+        return 8;
+    default:
+        return 4;
+    }
+}
+
+}
+
+ChainedFixups::ChainedFixups(AbstractFile& file, const uint8_t* data, size_t size, uint64_t imageBase)
+{
+    auto header = load<FixupsHeader>(data, size, 0);
+    if (header.version != 0)
+        throw std::runtime_error("Unsupported chained fixups version");
+
+    parseImports(data, size, header.importsOffset, header.importCount, header.importsFormat, header.symbolsOffset);
+
+    auto segmentCount = load<uint32_t>(data, size, header.startsOffset);
+    for (uint32_t i = 0; i < segmentCount; ++i) {
+        auto infoOffset = load<uint32_t>(data, size, header.startsOffset + 4 + uint64_t(i) * 4);
+        if (infoOffset != 0)
+            walkSegment(file, data, size, uint64_t(header.startsOffset) + infoOffset, imageBase);
+    }
+
+    // Chains are walked in address order within each page, but nothing
+    // requires segments to be listed in address order.
+    std::sort(m_fixups.begin(), m_fixups.end(),
+        [](const Fixup& a, const Fixup& b) { return a.location < b.location; });
+}
+
+void ChainedFixups::parseImports(const uint8_t* data, size_t size, uint32_t importsOffset, uint32_t importCount,
+    uint32_t importsFormat, uint32_t symbolsOffset)
+{
+    m_imports.reserve(importCount);
+
+    for (uint32_t i = 0; i < importCount; ++i) {
+        uint64_t nameOffset;
+        switch (importsFormat) {
+        case ImportFormatPlain:
+            nameOffset = load<uint32_t>(data, size, importsOffset + uint64_t(i) * 4) >> 9;
+            break;
+        case ImportFormatAddend:
+            nameOffset = load<uint32_t>(data, size, importsOffset + uint64_t(i) * 8) >> 9;
+            break;
+        case ImportFormatAddend64:
+            nameOffset = load<uint64_t>(data, size, importsOffset + uint64_t(i) * 16) >> 32;
+            break;
+        default:
+            throw std::runtime_error("Unsupported chained import format");
+        }
+
+        auto offset = uint64_t(symbolsOffset) + nameOffset;
+        if (offset >= size)
+            throw std::runtime_error("Truncated chained fixups");
+
+        auto name = reinterpret_cast<const char*>(data + offset);
+        m_imports.emplace_back(name, strnlen(name, size - offset));
+    }
+}
+
+void ChainedFixups::walkSegment(AbstractFile& file, const uint8_t* data, size_t size, uint64_t segmentInfoOffset,
+    uint64_t imageBase)
+{
+    auto starts = load<SegmentStarts>(data, size, segmentInfoOffset, SegmentStartsSize);
+    auto stride = chainStride(starts.pointerFormat);
+    auto pointerSize = starts.pointerFormat == PointerFormat32 ? 4 : 8;
+
+    auto pageStart = [&](uint64_t index) {
+        return load<uint16_t>(data, size, segmentInfoOffset + SegmentStartsSize + index * 2);
+    };
+
+    // Page starts are followed by the overflow starts of pages with several
+    // chains; `size` covers both.
+    if (starts.size < SegmentStartsSize + uint64_t(starts.pageCount) * 2)
+        throw std::runtime_error("Truncated chained fixups");
+    const uint64_t startCount = (starts.size - SegmentStartsSize) / 2;
+
+    std::vector<uint8_t> page(starts.pageSize);
+    size_t pageLength = 0;
+    auto walkChain = [&](uint64_t pageAddress, uint64_t offset) {
+        while (offset + pointerSize <= pageLength) {
+            uint64_t raw = 0;
+            std::memcpy(&raw, page.data() + offset, pointerSize);
+
+            auto entry = decodeEntry(raw, starts.pointerFormat, imageBase);
+
+            // 32-bit chains may contain non-pointer values; these are encoded
+            // as rebases to targets past the largest valid pointer.
+            if (entry.isBind)
+                m_fixups.push_back({ pageAddress + offset, 0, static_cast<uint32_t>(entry.value) });
+            else if (starts.pointerFormat != PointerFormat32 || entry.value <= starts.maxValidPointer)
+                m_fixups.push_back({ pageAddress + offset, entry.value, NoImport });
+
+            if (entry.next == 0)
+                break;
+
+            offset += uint64_t(entry.next) * stride;
+        }
+    };
+
+    for (uint64_t p = 0; p < starts.pageCount; ++p) {
+        auto start = pageStart(p);
+        if (start == PageStartNone)
+            continue;
+
+        // The last page of a segment may be cut short; chains are only
+        // followed through the bytes actually read.
+        auto pageAddress = imageBase + starts.segmentOffset + p * starts.pageSize;
+        pageLength = file.readBytes(pageAddress, page.data(), page.size());
+        if (pageLength == 0)
+            continue;
+
+        if (!(start & PageStartMulti)) {
+            walkChain(pageAddress, start);
+            continue;
+        }
+
+        // Pages with several chains point into an overflow list of starts,
+        // terminated by an entry with the last-start bit set.
+        for (uint64_t index = start & ~PageStartMulti;; ++index) {
+            if (index >= startCount)
+                throw std::runtime_error("Unterminated chained fixup starts");
+
+            auto overflowStart = pageStart(index);
+            walkChain(pageAddress, overflowStart & ~PageStartLast);
+            if (overflowStart & PageStartLast)
+                break;
+        }
+    }
+}
+
+const ChainedFixups::Fixup* ChainedFixups::find(uint64_t location) const
+{
+    auto it = std::lower_bound(m_fixups.begin(), m_fixups.end(), location,
+        [](const Fixup& fixup, uint64_t location) { return fixup.location < location; });
+    if (it == m_fixups.end() || it->location != location)
+        return nullptr;
+
+    return &*it;
+}
+
+std::pair<const ChainedFixups::Fixup*, const ChainedFixups::Fixup*> ChainedFixups::range(uint64_t begin,
+    uint64_t end) const
+{
+    auto compare = [](const Fixup& fixup, uint64_t location) { return fixup.location < location; };
+    auto first = std::lower_bound(m_fixups.begin(), m_fixups.end(), begin, compare);
+    auto last = std::lower_bound(first, m_fixups.end(), end, compare);
+
+    return { m_fixups.data() + (first - m_fixups.begin()), m_fixups.data() + (last - m_fixups.begin()) };
+}
+
+std::string_view ChainedFixups::importName(const Fixup& fixup) const
+{
+    if (!fixup.isBind() || fixup.import >= m_imports.size())
+        return {};
+
+    return m_imports[fixup.import];
+}
+
+}
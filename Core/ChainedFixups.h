@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+class AbstractFile;
+
+/**
+ * Table of the pointer fixups described by a Mach-O image's chained fixups
+ * (`LC_DYLD_CHAINED_FIXUPS`).
+ *
+ * The page starts of every segment are walked once, decoding each chain
+ * according to the segment's pointer format; the result is a table of every
+ * fixup location and its target, sorted by location. Rebases resolve to an
+ * absolute address, binds to the name of the imported symbol.
+ *
+ * The table is immutable once built and may be shared between threads.
+ */
+class ChainedFixups {
+public:
+    /**
+     * Import index used by rebases.
+     */
+    static constexpr uint32_t NoImport = UINT32_MAX;
+
+    struct Fixup {
+        uint64_t location;
+
+        /**
+         * Absolute target address of a rebase; zero for binds.
+         */
+        uint64_t target;
+
+        /**
+         * Index of the imported symbol of a bind, or NoImport for a rebase.
+         */
+        uint32_t import;
+
+        bool isBind() const { return import != NoImport; }
+    };
+
+private:
+    std::vector<Fixup> m_fixups;
+    std::vector<std::string> m_imports;
+
+    /**
+     * Parse the import table and symbol names.
+     */
+    void parseImports(const uint8_t* data, size_t size, uint32_t importsOffset, uint32_t importCount,
+        uint32_t importsFormat, uint32_t symbolsOffset);
+
+    /**
+     * Walk the chains of a single segment.
+     */
+    void walkSegment(AbstractFile&, const uint8_t* data, size_t size, uint64_t segmentInfoOffset, uint64_t imageBase);
+
+public:
+    /**
+     * Parse the chained fixups payload (the `LC_DYLD_CHAINED_FIXUPS` data
+     * in __LINKEDIT) of the image whose Mach-O header is at `imageBase`.
+     * Chains are read through `file`. Throws std::runtime_error if the
+     * payload is malformed or uses an unsupported format.
+     */
+    ChainedFixups(AbstractFile& file, const uint8_t* data, size_t size, uint64_t imageBase);
+
+    /**
+     * Get the fixup at the given location, or null if there is none.
+     */
+    const Fixup* find(uint64_t location) const;
+
+    /**
+     * Get the fixups with locations in the range [begin, end), in order.
+     */
+    std::pair<const Fixup*, const Fixup*> range(uint64_t begin, uint64_t end) const;
+
+    /**
+     * Get the name of the symbol imported by a bind.
+     */
+    std::string_view importName(const Fixup&) const;
+
+    size_t size() const { return m_fixups.size(); }
+};
+
+}
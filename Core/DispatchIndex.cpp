@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "DispatchIndex.h"
+
+#include <algorithm>
+
+namespace ObjectiveNinja {
+
+/**
+ * Mix the bits of a key. Keys are addresses, which share most of their high
+ * bits and are usually aligned, so they must be mixed before masking.
+ */
+static uint64_t mix(uint64_t key)
+{
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111eb;
+    key ^= key >> 31;
+    return key;
+}
+
+/**
+ * Get the smallest power of two not less than `value`.
+ */
+static size_t nextPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value)
+        result <<= 1;
+
+    return result;
+}
+
+uint64_t DispatchIndex::filterBits(uint64_t hash)
+{
+    // Three bits from a single 64-bit word, taken from hash bits that are not
+    // used to pick the word or the table slot.
+    return (1ull << ((hash >> 40) & 63)) | (1ull << ((hash >> 46) & 63)) | (1ull << ((hash >> 52) & 63));
+}
+
+template <typename Entries>
+void DispatchIndex::build(const Entries& entries)
+{
+    // Table at most three-quarters full; filter with 16-32 bits per entry.
+    m_slots.resize(nextPowerOfTwo(entries.size() + entries.size() / 3 + 1), { 0, 0 });
+    m_filter.resize(nextPowerOfTwo(entries.size() / 4 + 1), 0);
+
+    const auto slotMask = m_slots.size() - 1;
+    const auto filterMask = m_filter.size() - 1;
+
+    for (const auto& [key, value] : entries) {
+        if (key == 0 || value == 0)
+            continue;
+
+        const auto hash = mix(key);
+        auto slot = hash & slotMask;
+        while (m_slots[slot].key != 0)
+            slot = (slot + 1) & slotMask;
+
+        m_slots[slot] = { key, value };
+        m_filter[(hash >> 20) & filterMask] |= filterBits(hash);
+        ++m_size;
+    }
+}
+
+DispatchIndex::DispatchIndex(const std::unordered_map<uint64_t, uint64_t>& entries)
+{
+    build(entries);
+}
+
+DispatchIndex::DispatchIndex(const std::vector<std::pair<uint64_t, uint64_t>>& entries)
+{
+    build(entries);
+}
+
+uint64_t DispatchIndex::find(uint64_t key) const
+{
+    if (m_size == 0 || key == 0)
+        return 0;
+
+    const auto hash = mix(key);
+    const auto bits = filterBits(hash);
+    if ((m_filter[(hash >> 20) & (m_filter.size() - 1)] & bits) != bits)
+        return 0;
+
+    const auto slotMask = m_slots.size() - 1;
+    for (auto slot = hash & slotMask; m_slots[slot].key != 0; slot = (slot + 1) & slotMask)
+        if (m_slots[slot].key == key)
+            return m_slots[slot].value;
+
+    return 0;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> DispatchIndex::entries() const
+{
+    std::vector<std::pair<uint64_t, uint64_t>> result;
+    result.reserve(m_size);
+    for (const auto& slot : m_slots)
+        if (slot.key != 0)
+            result.emplace_back(slot.key, slot.value);
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+size_t DispatchIndex::bytes() const
+{
+    return m_slots.capacity() * sizeof(Slot) + m_filter.capacity() * sizeof(uint64_t);
+}
+
+}
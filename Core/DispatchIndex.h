@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Read-only index from selector (name or selector reference address) to
+ * method implementation, built once structure analysis is complete.
+ *
+ * Keys are stored in an open-addressing table with linear probing kept at
+ * most three-quarters full, so hits usually take one or two adjacent probes.
+ * Most lookups made by the workflow are for selectors implemented in other
+ * images, so a blocked Bloom filter sits in front of the table; a miss is
+ * usually rejected after reading a single word.
+ *
+ * The index is immutable after construction and safe to query from any
+ * number of threads.
+ */
+class DispatchIndex {
+    struct Slot {
+        uint64_t key;
+        uint64_t value;
+    };
+
+    std::vector<Slot> m_slots;
+    std::vector<uint64_t> m_filter;
+    size_t m_size = 0;
+
+    /**
+     * Get the Bloom filter bits for a key within its filter word.
+     */
+    static uint64_t filterBits(uint64_t hash);
+
+    template <typename Entries>
+    void build(const Entries&);
+
+public:
+    DispatchIndex() = default;
+
+    /**
+     * Build an index from a map of selector to implementation addresses.
+     * Entries with a zero key or value are ignored.
+     */
+    explicit DispatchIndex(const std::unordered_map<uint64_t, uint64_t>&);
+
+    /**
+     * Build an index from a list of selector and implementation address
+     * pairs. Keys must be unique.
+     */
+    explicit DispatchIndex(const std::vector<std::pair<uint64_t, uint64_t>>&);
+
+    /**
+     * Get the implementation address for a selector, or zero if unknown.
+     */
+    uint64_t find(uint64_t key) const;
+
+    /**
+     * Get all entries in the index, sorted by key.
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> entries() const;
+
+    /**
+     * Get the number of entries in the index.
+     */
+    size_t size() const { return m_size; }
+
+    /**
+     * Get the number of bytes used by the index.
+     */
+    size_t bytes() const;
+};
+
+}
@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+// This header is self-contained and has no dependencies outside the standard
+// library, so that external tools can read exports without linking against
+// the rest of the core library or Binary Ninja.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace ObjectiveNinja {
+
+/**
+ * Columnar export of Objective-C analysis results.
+ *
+ * An export is a header followed by fixed-width tables and a blob of
+ * NUL-terminated strings. Every table starts at an 8-byte aligned offset and
+ * all integers are little-endian, so a file mapped into memory can be
+ * queried in place, without any parsing or copying.
+ *
+ * Classes, selector references and CFStrings are sorted by address. Methods
+ * are grouped by class: the instance methods of a class come first, followed
+ * by its class methods.
+ */
+namespace Export {
+
+constexpr uint32_t Magic = 0x584E4F4F; // "OONX"
+constexpr uint32_t Version = 1;
+
+/**
+ * Reference to a string in the string blob.
+ */
+struct String {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Class {
+    uint64_t address;
+    uint64_t metaClassAddress;
+    String name;
+
+    /**
+     * Index of the first method of the class in the method table.
+     */
+    uint32_t firstMethod;
+    uint32_t instanceMethodCount;
+    uint32_t classMethodCount;
+    uint32_t reserved;
+};
+
+struct Method {
+    uint64_t address;
+    uint64_t implAddress;
+    String selector;
+    String type;
+
+    /**
+     * Index of the class the method belongs to in the class table.
+     */
+    uint32_t classIndex;
+    uint32_t flags;
+};
+
+constexpr uint32_t MethodIsClassMethod = 1;
+
+struct Selector {
+    uint64_t address;
+    uint64_t rawSelector;
+    uint64_t nameAddress;
+    String name;
+};
+
+struct CFString {
+    uint64_t address;
+    uint64_t dataAddress;
+    uint64_t size;
+};
+
+struct Table {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+
+    Table classes;
+    Table methods;
+    Table selectors;
+    Table cfStrings;
+
+    /**
+     * Offset and size in bytes of the string blob.
+     */
+    Table strings;
+};
+
+static_assert(sizeof(String) == 8);
+static_assert(sizeof(Class) == 40);
+static_assert(sizeof(Method) == 40);
+static_assert(sizeof(Selector) == 32);
+static_assert(sizeof(CFString) == 24);
+static_assert(sizeof(Header) == 88);
+
+/**
+ * Exception thrown when an export is malformed or of another version.
+ */
+class FormatError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Read-only view of a contiguous array of rows.
+ */
+template <typename T>
+class Span {
+    const T* m_data = nullptr;
+    size_t m_size = 0;
+
+public:
+    Span() = default;
+    Span(const T* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    const T* begin() const { return m_data; }
+    const T* end() const { return m_data + m_size; }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const T& operator[](size_t index) const { return m_data[index]; }
+};
+
+/**
+ * Zero-copy reader over an export held in memory, typically a mapped file.
+ *
+ * The data must be 8-byte aligned and outlive the reader, along with any
+ * rows or strings obtained from it. Construction validates the header and
+ * table bounds, so row and string accessors do no further checking beyond
+ * what is noted.
+ */
+class Reader {
+    const uint8_t* m_data;
+    Header m_header;
+
+    template <typename T>
+    Span<T> table(const Table& table) const
+    {
+        return { reinterpret_cast<const T*>(m_data + table.offset), static_cast<size_t>(table.count) };
+    }
+
+    template <typename T>
+    static void checkTable(const Table& table, size_t size)
+    {
+        if (table.offset % alignof(uint64_t) != 0 || table.offset > size
+            || table.count > (size - table.offset) / sizeof(T))
+            throw FormatError("Export table out of bounds");
+    }
+
+    /**
+     * Find the row with the given address in a table sorted by address.
+     */
+    template <typename T>
+    static const T* findByAddress(Span<T> rows, uint64_t address)
+    {
+        auto it = std::lower_bound(rows.begin(), rows.end(), address,
+            [](const T& row, uint64_t value) { return row.address < value; });
+
+        return it != rows.end() && it->address == address ? it : nullptr;
+    }
+
+public:
+    Reader(const void* data, size_t size)
+        : m_data(static_cast<const uint8_t*>(data))
+    {
+        if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0)
+            throw FormatError("Export data is not aligned");
+        if (size < sizeof(Header))
+            throw FormatError("Truncated export");
+
+        std::memcpy(&m_header, m_data, sizeof(Header));
+        if (m_header.magic != Magic)
+            throw FormatError("Not an Objective-C analysis export");
+        if (m_header.version != Version)
+            throw FormatError("Unsupported export version");
+
+        checkTable<Class>(m_header.classes, size);
+        checkTable<Method>(m_header.methods, size);
+        checkTable<Selector>(m_header.selectors, size);
+        checkTable<CFString>(m_header.cfStrings, size);
+        checkTable<char>(m_header.strings, size);
+    }
+
+    Span<Class> classes() const { return table<Class>(m_header.classes); }
+    Span<Method> methods() const { return table<Method>(m_header.methods); }
+    Span<Selector> selectors() const { return table<Selector>(m_header.selectors); }
+    Span<CFString> cfStrings() const { return table<CFString>(m_header.cfStrings); }
+
+    /**
+     * Get a string from the string blob. Out of range references yield an
+     * empty string.
+     */
+    std::string_view string(String ref) const
+    {
+        const auto& blob = m_header.strings;
+        if (ref.offset > blob.count || ref.length > blob.count - ref.offset)
+            return {};
+
+        return { reinterpret_cast<const char*>(m_data + blob.offset + ref.offset), ref.length };
+    }
+
+    /**
+     * Get the methods of a class; instance methods first, then class
+     * methods. Out of range method ranges yield no methods.
+     */
+    Span<Method> methodsOf(const Class& cls) const
+    {
+        auto all = methods();
+        auto count = static_cast<size_t>(cls.instanceMethodCount) + cls.classMethodCount;
+        if (cls.firstMethod > all.size() || count > all.size() - cls.firstMethod)
+            return {};
+
+        return { all.begin() + cls.firstMethod, count };
+    }
+
+    const Class* findClass(uint64_t address) const { return findByAddress(classes(), address); }
+    const Selector* findSelector(uint64_t address) const { return findByAddress(selectors(), address); }
+    const CFString* findCFString(uint64_t address) const { return findByAddress(cfStrings(), address); }
+};
+
+}
+
+}
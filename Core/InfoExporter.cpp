@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "InfoExporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace ObjectiveNinja {
+
+namespace {
+
+/**
+ * Deduplicating builder for the string blob.
+ */
+class StringBlob {
+    std::vector<char> m_data;
+    std::unordered_map<std::string_view, Export::String> m_refs;
+
+public:
+    Export::String add(std::string_view text)
+    {
+        if (auto it = m_refs.find(text); it != m_refs.end())
+            return it->second;
+
+        Export::String ref { static_cast<uint32_t>(m_data.size()), static_cast<uint32_t>(text.size()) };
+        m_data.insert(m_data.end(), text.begin(), text.end());
+        m_data.push_back('\0');
+
+        m_refs.emplace(text, ref);
+        return ref;
+    }
+
+    const std::vector<char>& data() const { return m_data; }
+};
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + alignof(uint64_t) - 1) & ~uint64_t(alignof(uint64_t) - 1);
+}
+
+/**
+ * Append a table at the next aligned offset of `output`.
+ */
+template <typename T>
+Export::Table appendTable(std::vector<uint8_t>& output, const std::vector<T>& rows)
+{
+    Export::Table table { alignUp(output.size()), rows.size() };
+
+    output.resize(table.offset + rows.size() * sizeof(T));
+    if (!rows.empty())
+        std::memcpy(output.data() + table.offset, rows.data(), rows.size() * sizeof(T));
+
+    return table;
+}
+
+template <typename T>
+void sortByAddress(std::vector<T>& rows)
+{
+    std::sort(rows.begin(), rows.end(), [](const T& a, const T& b) { return a.address < b.address; });
+}
+
+void appendMethods(std::vector<Export::Method>& methods, StringBlob& strings, const MethodListInfo* mli,
+    uint32_t classIndex, uint32_t flags)
+{
+    if (!mli)
+        return;
+
+    for (const auto& mi : mli->methods)
+        methods.push_back({ mi.address, mi.implAddress, strings.add(mi.selector), strings.add(mi.type), classIndex,
+            flags });
+}
+
+}
+
+std::vector<uint8_t> InfoExporter::exportInfo(const AnalysisInfo& info)
+{
+    StringBlob strings;
+
+    // Classes are sorted before methods are gathered, so that each class's
+    // methods can refer to its final index.
+    std::vector<const ClassInfo*> sortedClasses;
+    sortedClasses.reserve(info.classes.size());
+    for (const auto& ci : info.classes)
+        sortedClasses.push_back(&ci);
+    std::sort(sortedClasses.begin(), sortedClasses.end(),
+        [](const ClassInfo* a, const ClassInfo* b) { return a->address < b->address; });
+
+    std::vector<Export::Class> classes;
+    std::vector<Export::Method> methods;
+    classes.reserve(sortedClasses.size());
+
+    for (const auto* ci : sortedClasses) {
+        auto classIndex = static_cast<uint32_t>(classes.size());
+        const auto* mci = ci->metaClassInfo;
+
+        Export::Class row {};
+        row.address = ci->address;
+        row.metaClassAddress = mci ? mci->info.address : 0;
+        row.name = strings.add(ci->name);
+        row.firstMethod = static_cast<uint32_t>(methods.size());
+
+        appendMethods(methods, strings, ci->methodList.get(), classIndex, 0);
+        row.instanceMethodCount = static_cast<uint32_t>(methods.size()) - row.firstMethod;
+
+        appendMethods(methods, strings, mci ? mci->info.methodList.get() : nullptr, classIndex,
+            Export::MethodIsClassMethod);
+        row.classMethodCount = static_cast<uint32_t>(methods.size()) - row.firstMethod - row.instanceMethodCount;
+
+        classes.push_back(row);
+    }
+
+    std::vector<Export::Selector> selectors;
+    selectors.reserve(info.selectorRefs.size());
+    for (const auto sr : info.selectorRefs)
+        selectors.push_back({ sr.address, sr.rawSelector, sr.nameAddress, strings.add(sr.name) });
+    sortByAddress(selectors);
+
+    std::vector<Export::CFString> cfStrings;
+    cfStrings.reserve(info.cfStrings.size());
+    for (const auto& csi : info.cfStrings)
+        cfStrings.push_back({ csi.address, csi.dataAddress, csi.size });
+    sortByAddress(cfStrings);
+
+    std::vector<uint8_t> output(sizeof(Export::Header));
+
+    Export::Header header {};
+    header.magic = Export::Magic;
+    header.version = Export::Version;
+    header.classes = appendTable(output, classes);
+    header.methods = appendTable(output, methods);
+    header.selectors = appendTable(output, selectors);
+    header.cfStrings = appendTable(output, cfStrings);
+    header.strings = appendTable(output, strings.data());
+
+    std::memcpy(output.data(), &header, sizeof(header));
+    return output;
+}
+
+}
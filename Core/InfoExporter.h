@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AnalysisInfo.h"
+#include "ExportFormat.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Writer for the columnar export format described in ExportFormat.h.
+ */
+class InfoExporter {
+public:
+    /**
+     * Export the classes, methods, selector references and CFStrings of an
+     * info. Deferred method lists must be resolved first, or classes are
+     * exported without methods.
+     */
+    static std::vector<uint8_t> exportInfo(const AnalysisInfo&);
+};
+
+}
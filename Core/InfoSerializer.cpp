@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "InfoSerializer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+namespace ObjectiveNinja {
+
+namespace {
+
+constexpr uint32_t Magic = 0x49414E4F; // "ONAI"
+constexpr uint32_t NoIndex = UINT32_MAX;
+
+/**
+ * Append-only little-endian output buffer.
+ */
+class Writer {
+    std::vector<uint8_t> m_data;
+    std::unordered_map<std::string_view, uint32_t> m_stringIndices;
+    std::vector<std::string_view> m_strings;
+
+public:
+    template <typename T>
+    void write(T value)
+    {
+        static_assert(std::is_integral_v<T>);
+
+        auto offset = m_data.size();
+        m_data.resize(offset + sizeof(T));
+        std::memcpy(m_data.data() + offset, &value, sizeof(T));
+    }
+
+    void writeBytes(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+
+    /**
+     * Write a reference to a string, adding it to the string table.
+     */
+    void writeString(std::string_view text)
+    {
+        auto [it, inserted] = m_stringIndices.emplace(text, static_cast<uint32_t>(m_strings.size()));
+        if (inserted)
+            m_strings.push_back(text);
+
+        write(it->second);
+    }
+
+    const std::vector<std::string_view>& strings() const { return m_strings; }
+    std::vector<uint8_t>& data() { return m_data; }
+};
+
+/**
+ * Bounds-checked little-endian input buffer.
+ */
+class Reader {
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+
+    std::vector<std::string_view> m_strings;
+
+public:
+    Reader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    template <typename T>
+    T read()
+    {
+        static_assert(std::is_integral_v<T>);
+
+        T value;
+        std::memcpy(&value, bytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    const uint8_t* bytes(size_t size)
+    {
+        if (size > m_size - m_offset)
+            throw SerializationError("Truncated analysis info");
+
+        auto result = m_data + m_offset;
+        m_offset += size;
+        return result;
+    }
+
+    /**
+     * Read an element count, rejecting counts that could not possibly fit in
+     * the remaining data, given a minimum encoded size per element.
+     */
+    size_t readCount(size_t minimumElementSize)
+    {
+        auto count = read<uint64_t>();
+        if (count > (m_size - m_offset) / std::max<size_t>(minimumElementSize, 1))
+            throw SerializationError("Invalid element count");
+
+        return static_cast<size_t>(count);
+    }
+
+    void setStrings(std::vector<std::string_view> strings) { m_strings = std::move(strings); }
+
+    std::string_view readString()
+    {
+        auto index = read<uint32_t>();
+        if (index >= m_strings.size())
+            throw SerializationError("Invalid string index");
+
+        return m_strings[index];
+    }
+
+    bool atEnd() const { return m_offset == m_size; }
+};
+
+template <typename T>
+uint32_t indexOf(const std::unordered_map<const T*, uint32_t>& indices, const T* item)
+{
+    if (!item)
+        return NoIndex;
+
+    return indices.at(item);
+}
+
+template <typename T>
+const T& itemAt(const std::vector<T>& items, uint32_t index)
+{
+    if (index >= items.size())
+        throw SerializationError("Invalid table index");
+
+    return items[index];
+}
+
+void writeMethodList(Writer& writer, const MethodListInfo& mli)
+{
+    writer.write(mli.address);
+    writer.write(mli.flags);
+    writer.write<uint64_t>(mli.methods.size());
+    for (const auto& mi : mli.methods) {
+        writer.write(mi.address);
+        writer.writeString(mi.selector);
+        writer.writeString(mi.type);
+        writer.write(mi.nameAddress);
+        writer.write(mi.typeAddress);
+        writer.write(mi.implAddress);
+    }
+}
+
+MethodListInfo readMethodList(Reader& reader)
+{
+    MethodListInfo mli;
+    mli.address = reader.read<uint64_t>();
+    mli.flags = reader.read<uint32_t>();
+
+    mli.methods.resize(reader.readCount(40));
+    for (auto& mi : mli.methods) {
+        mi.address = reader.read<uint64_t>();
+        mi.selector = reader.readString();
+        mi.type = reader.readString();
+        mi.nameAddress = reader.read<uint64_t>();
+        mi.typeAddress = reader.read<uint64_t>();
+        mi.implAddress = reader.read<uint64_t>();
+    }
+
+    return mli;
+}
+
+void writeIvarList(Writer& writer, const IvarListInfo& ili)
+{
+    writer.write(ili.address);
+    writer.write(ili.count);
+    writer.write<uint64_t>(ili.ivars.size());
+    for (const auto& ii : ili.ivars) {
+        writer.write(ii.address);
+        writer.write(ii.offset);
+        writer.writeString(ii.name);
+        writer.writeString(ii.type);
+        writer.write(ii.offsetAddress);
+        writer.write(ii.nameAddress);
+        writer.write(ii.typeAddress);
+        writer.write(ii.size);
+    }
+}
+
+IvarListInfo readIvarList(Reader& reader)
+{
+    IvarListInfo ili;
+    ili.address = reader.read<uint64_t>();
+    ili.count = reader.read<uint32_t>();
+
+    ili.ivars.resize(reader.readCount(48));
+    for (auto& ii : ili.ivars) {
+        ii.address = reader.read<uint64_t>();
+        ii.offset = reader.read<uint32_t>();
+        ii.name = reader.readString();
+        ii.type = reader.readString();
+        ii.offsetAddress = reader.read<uint64_t>();
+        ii.nameAddress = reader.read<uint64_t>();
+        ii.typeAddress = reader.read<uint64_t>();
+        ii.size = reader.read<uint32_t>();
+    }
+
+    return ili;
+}
+
+/**
+ * Indices of the shared method lists, ivar lists and metaclasses of an info.
+ */
+struct SharedTables {
+    std::unordered_map<const MethodListInfo*, uint32_t> methodLists;
+    std::unordered_map<const IvarListInfo*, uint32_t> ivarLists;
+    std::unordered_map<const MetaClassInfo*, uint32_t> metaClasses;
+
+    std::vector<const MethodListInfo*> methodListOrder;
+    std::vector<const IvarListInfo*> ivarListOrder;
+    std::vector<const MetaClassInfo*> metaClassOrder;
+
+    void addClass(const ClassInfo& ci)
+    {
+        if (ci.methodList && methodLists.emplace(ci.methodList.get(), methodListOrder.size()).second)
+            methodListOrder.push_back(ci.methodList.get());
+        if (ci.ivarList && ivarLists.emplace(ci.ivarList.get(), ivarListOrder.size()).second)
+            ivarListOrder.push_back(ci.ivarList.get());
+    }
+};
+
+void writeClass(Writer& writer, const SharedTables& tables, const ClassInfo& ci)
+{
+    // Metaclasses do not have metaclasses of their own.
+    const MetaClassInfo* mci = ci.isMetaClass ? nullptr : ci.metaClassInfo;
+
+    writer.write(ci.address);
+    writer.write<uint8_t>(ci.isMetaClass);
+    writer.write(indexOf(tables.metaClasses, mci));
+    writer.writeString(ci.name);
+    writer.write(indexOf(tables.methodLists, ci.methodList.get()));
+    writer.write(indexOf(tables.ivarLists, ci.ivarList.get()));
+    writer.write(ci.listPointer);
+    writer.write(ci.dataAddress);
+    writer.write(ci.nameAddress);
+    writer.write(ci.methodListAddress);
+    writer.write(ci.ivarListAddress);
+}
+
+struct ReadTables {
+    std::vector<std::shared_ptr<const MethodListInfo>> methodLists;
+    std::vector<std::shared_ptr<const IvarListInfo>> ivarLists;
+    std::vector<MetaClassInfo*> metaClasses;
+};
+
+ClassInfo readClass(Reader& reader, const ReadTables& tables)
+{
+    ClassInfo ci;
+    ci.address = reader.read<uint64_t>();
+    ci.isMetaClass = reader.read<uint8_t>() != 0;
+
+    auto metaClassIndex = reader.read<uint32_t>();
+    ci.metaClassInfo = metaClassIndex == NoIndex ? nullptr : itemAt(tables.metaClasses, metaClassIndex);
+
+    ci.name = reader.readString();
+
+    auto methodListIndex = reader.read<uint32_t>();
+    if (methodListIndex != NoIndex)
+        ci.methodList = itemAt(tables.methodLists, methodListIndex);
+
+    auto ivarListIndex = reader.read<uint32_t>();
+    if (ivarListIndex != NoIndex)
+        ci.ivarList = itemAt(tables.ivarLists, ivarListIndex);
+
+    ci.listPointer = reader.read<uint64_t>();
+    ci.dataAddress = reader.read<uint64_t>();
+    ci.nameAddress = reader.read<uint64_t>();
+    ci.methodListAddress = reader.read<uint64_t>();
+    ci.ivarListAddress = reader.read<uint64_t>();
+    return ci;
+}
+
+void writeClassRefs(Writer& writer, const std::vector<ClassRefInfo>& refs)
+{
+    writer.write<uint64_t>(refs.size());
+    for (const auto& ref : refs) {
+        writer.write(ref.address);
+        writer.write(ref.referencedAddress);
+        writer.writeString(ref.importedName);
+    }
+}
+
+std::vector<ClassRefInfo> readClassRefs(Reader& reader)
+{
+    std::vector<ClassRefInfo> refs(reader.readCount(20));
+    for (auto& ref : refs) {
+        ref.address = reader.read<uint64_t>();
+        ref.referencedAddress = reader.read<uint64_t>();
+        ref.importedName = reader.readString();
+    }
+
+    return refs;
+}
+
+}
+
+std::vector<uint8_t> InfoSerializer::serialize(const AnalysisInfo& info)
+{
+    // Shared lists and metaclasses are collected first, so that classes can
+    // refer to them by index.
+    SharedTables tables;
+    for (const auto& ci : info.classes) {
+        tables.addClass(ci);
+
+        const MetaClassInfo* mci = ci.metaClassInfo;
+        if (mci && tables.metaClasses.emplace(mci, tables.metaClassOrder.size()).second) {
+            tables.metaClassOrder.push_back(mci);
+            tables.addClass(mci->info);
+        }
+    }
+
+    Writer body;
+
+    body.write<uint64_t>(tables.methodListOrder.size());
+    for (const auto* mli : tables.methodListOrder)
+        writeMethodList(body, *mli);
+
+    body.write<uint64_t>(tables.ivarListOrder.size());
+    for (const auto* ili : tables.ivarListOrder)
+        writeIvarList(body, *ili);
+
+    body.write<uint64_t>(tables.metaClassOrder.size());
+    for (const auto* mci : tables.metaClassOrder) {
+        body.writeString(mci->name);
+        body.write<uint8_t>(mci->imported);
+        writeClass(body, tables, mci->info);
+    }
+
+    body.write<uint64_t>(info.classes.size());
+    for (const auto& ci : info.classes)
+        writeClass(body, tables, ci);
+
+    body.write<uint64_t>(info.cfStrings.size());
+    for (const auto& csi : info.cfStrings) {
+        body.write(csi.address);
+        body.write(csi.dataAddress);
+        body.write<uint64_t>(csi.size);
+    }
+
+    writeClassRefs(body, info.classRefs);
+    writeClassRefs(body, info.superRefs);
+
+    body.write<uint64_t>(info.selectorRefs.size());
+    for (const auto sr : info.selectorRefs) {
+        body.write(sr.address);
+        body.write(sr.rawSelector);
+        body.write(sr.nameAddress);
+        body.writeString(sr.name);
+    }
+
+    // Sorted, so identical infos serialize identically.
+    const auto methodImpls = info.dispatchIndex.entries();
+
+    body.write<uint64_t>(methodImpls.size());
+    for (const auto& [selector, impl] : methodImpls) {
+        body.write(selector);
+        body.write(impl);
+    }
+
+    // The string table can only be written once everything referencing it
+    // has been, but is needed first when reading.
+    Writer result;
+    result.write(Magic);
+    result.write(Version);
+    result.write<uint64_t>(body.strings().size());
+    for (const auto text : body.strings()) {
+        result.write<uint32_t>(static_cast<uint32_t>(text.size()));
+        result.writeBytes(text.data(), text.size());
+    }
+    result.writeBytes(body.data().data(), body.data().size());
+
+    return std::move(result.data());
+}
+
+std::shared_ptr<AnalysisInfo> InfoSerializer::deserialize(const uint8_t* data, size_t size)
+{
+    Reader reader(data, size);
+    if (reader.read<uint32_t>() != Magic)
+        throw SerializationError("Not serialized analysis info");
+    if (reader.read<uint32_t>() != Version)
+        throw SerializationError("Unsupported analysis info version");
+
+    auto info = std::make_shared<AnalysisInfo>();
+
+    std::vector<std::string_view> strings(reader.readCount(4));
+    for (auto& text : strings) {
+        auto length = reader.read<uint32_t>();
+        text = info->strings.intern({ reinterpret_cast<const char*>(reader.bytes(length)), length });
+    }
+    reader.setStrings(std::move(strings));
+
+    ReadTables tables;
+
+    tables.methodLists.resize(reader.readCount(20));
+    for (auto& mli : tables.methodLists)
+        mli = std::make_shared<const MethodListInfo>(readMethodList(reader));
+
+    tables.ivarLists.resize(reader.readCount(20));
+    for (auto& ili : tables.ivarLists)
+        ili = std::make_shared<const IvarListInfo>(readIvarList(reader));
+
+    // Metaclass entries never refer to other metaclasses, so they can be
+    // read against the tables as they stand.
+    tables.metaClasses.resize(reader.readCount(70));
+    info->metaClasses.reserve(tables.metaClasses.size());
+    for (auto& mci : tables.metaClasses) {
+        mci = info->metaClasses.emplace_back(std::make_unique<MetaClassInfo>()).get();
+        mci->name = reader.readString();
+        mci->imported = reader.read<uint8_t>() != 0;
+        mci->info = readClass(reader, tables);
+    }
+
+    info->classes.resize(reader.readCount(65));
+    for (auto& ci : info->classes)
+        ci = readClass(reader, tables);
+
+    info->cfStrings.resize(reader.readCount(24));
+    for (auto& csi : info->cfStrings) {
+        csi.address = reader.read<uint64_t>();
+        csi.dataAddress = reader.read<uint64_t>();
+        csi.size = static_cast<size_t>(reader.read<uint64_t>());
+    }
+
+    info->classRefs = readClassRefs(reader);
+    info->superRefs = readClassRefs(reader);
+
+    auto selectorCount = reader.readCount(28);
+    info->selectorRefs.reserve(selectorCount);
+    for (size_t i = 0; i < selectorCount; ++i) {
+        auto address = reader.read<uint64_t>();
+        auto rawSelector = reader.read<uint64_t>();
+        auto nameAddress = reader.read<uint64_t>();
+        info->selectorRefs.add(address, rawSelector, nameAddress, reader.readString());
+    }
+    info->selectorRefs.buildIndices();
+
+    std::vector<std::pair<uint64_t, uint64_t>> methodImpls(reader.readCount(16));
+    for (auto& [selector, impl] : methodImpls) {
+        selector = reader.read<uint64_t>();
+        impl = reader.read<uint64_t>();
+    }
+
+    // Entries are written sorted by selector; checking that they still are
+    // also guarantees the unique keys the index requires.
+    if (std::adjacent_find(methodImpls.begin(), methodImpls.end(),
+            [](const auto& a, const auto& b) { return a.first >= b.first; })
+        != methodImpls.end())
+        throw SerializationError("Unsorted method implementations");
+    info->dispatchIndex = DispatchIndex(methodImpls);
+
+    if (!reader.atEnd())
+        throw SerializationError("Trailing data after analysis info");
+
+    return info;
+}
+
+}
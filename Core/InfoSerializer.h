@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AnalysisInfo.h"
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Exception thrown when serialized info is malformed or has an unsupported
+ * version.
+ */
+class SerializationError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Compact, versioned binary serialization of AnalysisInfo.
+ *
+ * All strings are written once to a deduplicated string table and referenced
+ * by index. Method and ivar lists shared between classes, and metaclasses,
+ * are likewise written once. Integers are stored little-endian.
+ *
+ * Deferred method lists cannot be serialized; infos should only be
+ * serialized once methods have been resolved.
+ */
+class InfoSerializer {
+public:
+    /**
+     * Format version; bumped whenever the layout changes. Data written with
+     * any other version is rejected.
+     */
+    static constexpr uint32_t Version = 1;
+
+    /**
+     * Serialize an info.
+     */
+    static std::vector<uint8_t> serialize(const AnalysisInfo&);
+
+    /**
+     * Deserialize an info, rebuilding its lookup indices. Throws
+     * SerializationError if the data is malformed or of another version.
+     */
+    static std::shared_ptr<AnalysisInfo> deserialize(const uint8_t* data, size_t size);
+};
+
+}
@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "MachOFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ObjectiveNinja {
+
+namespace {
+
+constexpr uint32_t MachMagic32 = 0xFEEDFACE;
+constexpr uint32_t MachMagic64 = 0xFEEDFACF;
+constexpr uint32_t FatMagic32 = 0xCAFEBABE;
+constexpr uint32_t FatMagic64 = 0xCAFEBABF;
+
+constexpr uint32_t LoadCommandSegment32 = 0x1;
+constexpr uint32_t LoadCommandSegment64 = 0x19;
+constexpr uint32_t LoadCommandChainedFixups = 0x80000034;
+
+struct MachHeader {
+    uint32_t magic;
+    int32_t cpuType;
+    int32_t cpuSubtype;
+    uint32_t fileType;
+    uint32_t commandCount;
+    uint32_t commandsSize;
+    uint32_t flags;
+};
+
+struct LoadCommand {
+    uint32_t command;
+    uint32_t size;
+};
+
+struct LinkEditDataCommand {
+    uint32_t command;
+    uint32_t size;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+};
+
+struct SegmentCommand32 {
+    uint32_t command;
+    uint32_t size;
+    char name[16];
+    uint32_t address;
+    uint32_t addressSize;
+    uint32_t fileOffset;
+    uint32_t fileSize;
+    int32_t maxProtection;
+    int32_t initialProtection;
+    uint32_t sectionCount;
+    uint32_t flags;
+};
+
+struct SegmentCommand64 {
+    uint32_t command;
+    uint32_t size;
+    char name[16];
+    uint64_t address;
+    uint64_t addressSize;
+    uint64_t fileOffset;
+    uint64_t fileSize;
+    int32_t maxProtection;
+    int32_t initialProtection;
+    uint32_t sectionCount;
+    uint32_t flags;
+};
+
+struct Section32 {
+    char name[16];
+    char segmentName[16];
+    uint32_t address;
+    uint32_t size;
+    uint32_t offset;
+    uint32_t align;
+    uint32_t relocationOffset;
+    uint32_t relocationCount;
+    uint32_t flags;
+    uint32_t reserved1;
+    uint32_t reserved2;
+};
+
+struct Section64 {
+    char name[16];
+    char segmentName[16];
+    uint64_t address;
+    uint64_t size;
+    uint32_t offset;
+    uint32_t align;
+    uint32_t relocationOffset;
+    uint32_t relocationCount;
+    uint32_t flags;
+    uint32_t reserved1;
+    uint32_t reserved2;
+    uint32_t reserved3;
+};
+
+/**
+ * Copy a structure out of a buffer, throwing if it would run past the end.
+ */
+template <typename T>
+T load(const uint8_t* data, size_t size, uint64_t offset)
+{
+    if (offset > size || size - offset < sizeof(T))
+        throw std::runtime_error("Truncated Mach-O file");
+
+    T result;
+    std::memcpy(&result, data + offset, sizeof(T));
+    return result;
+}
+
+uint32_t swap32(uint32_t value)
+{
+    return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8)
+        | ((value >> 8) & 0xFF00) | (value >> 24);
+}
+
+uint64_t swap64(uint64_t value)
+{
+    return (static_cast<uint64_t>(swap32(static_cast<uint32_t>(value))) << 32)
+        | swap32(static_cast<uint32_t>(value >> 32));
+}
+
+std::string fixedString(const char (&text)[16])
+{
+    return std::string(text, strnlen(text, sizeof(text)));
+}
+
+}
+
+/**
+ * Read-only mapping of a file, shared by a MachOFile and its clones.
+ */
+class MachOFile::Mapping {
+#ifdef _WIN32
+    HANDLE m_fileHandle = nullptr;
+    HANDLE m_mappingHandle = nullptr;
+#endif
+
+    void unmap();
+
+public:
+    void* data = nullptr;
+    size_t size = 0;
+
+    explicit Mapping(const std::string& path);
+    ~Mapping() { unmap(); }
+
+    Mapping(const Mapping&) = delete;
+    Mapping& operator=(const Mapping&) = delete;
+};
+
+#ifdef _WIN32
+
+MachOFile::Mapping::Mapping(const std::string& path)
+{
+    m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE) {
+        m_fileHandle = nullptr;
+        throw std::runtime_error("Failed to open " + path);
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        unmap();
+        throw std::runtime_error("Failed to get size of " + path);
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mappingHandle)
+        data = MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        unmap();
+        throw std::runtime_error("Failed to map " + path);
+    }
+}
+
+void MachOFile::Mapping::unmap()
+{
+    if (data)
+        UnmapViewOfFile(data);
+    if (m_mappingHandle)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle)
+        CloseHandle(m_fileHandle);
+
+    data = nullptr;
+    m_mappingHandle = nullptr;
+    m_fileHandle = nullptr;
+}
+
+#else
+
+MachOFile::Mapping::Mapping(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open " + path);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to get size of " + path);
+    }
+    size = static_cast<size_t>(st.st_size);
+
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw std::runtime_error("Failed to map " + path);
+    }
+}
+
+void MachOFile::Mapping::unmap()
+{
+    if (data)
+        munmap(data, size);
+
+    data = nullptr;
+}
+
+#endif
+
+MachOFile::MachOFile(const std::string& path)
+    : m_mapping(std::make_shared<Mapping>(path))
+{
+    selectImage();
+    parseLoadCommands();
+}
+
+MachOFile::~MachOFile() = default;
+
+std::shared_ptr<AbstractFile> MachOFile::clone() const
+{
+    auto result = std::shared_ptr<MachOFile>(new MachOFile(*this));
+    result->m_offset = 0;
+
+    return result;
+}
+
+void MachOFile::selectImage()
+{
+    auto data = static_cast<const uint8_t*>(m_mapping->data);
+    auto dataSize = m_mapping->size;
+    m_image = data;
+    m_imageSize = dataSize;
+
+    auto magic = swap32(load<uint32_t>(data, dataSize, 0));
+    if (magic != FatMagic32 && magic != FatMagic64)
+        return;
+
+    // Universal binary headers are always big-endian. Prefer the first 64-bit
+    // slice, falling back to the first slice of any kind.
+    auto archCount = swap32(load<uint32_t>(data, dataSize, 4));
+    auto archSize = magic == FatMagic64 ? 32 : 20;
+
+    const uint8_t* fallback = nullptr;
+    size_t fallbackSize = 0;
+    for (uint32_t i = 0; i < archCount; ++i) {
+        uint64_t entry = 8 + static_cast<uint64_t>(i) * archSize;
+
+        uint64_t offset, size;
+        if (magic == FatMagic64) {
+            offset = swap64(load<uint64_t>(data, dataSize, entry + 8));
+            size = swap64(load<uint64_t>(data, dataSize, entry + 16));
+        } else {
+            offset = swap32(load<uint32_t>(data, dataSize, entry + 8));
+            size = swap32(load<uint32_t>(data, dataSize, entry + 12));
+        }
+
+        if (offset > dataSize || size > dataSize - offset)
+            continue;
+
+        if (load<uint32_t>(data, dataSize, offset) == MachMagic64) {
+            m_image = data + offset;
+            m_imageSize = size;
+            return;
+        }
+
+        if (!fallback) {
+            fallback = data + offset;
+            fallbackSize = size;
+        }
+    }
+
+    if (!fallback)
+        throw std::runtime_error("No usable slice in universal binary");
+
+    m_image = fallback;
+    m_imageSize = fallbackSize;
+}
+
+void MachOFile::parseLoadCommands()
+{
+    auto header = load<MachHeader>(m_image, m_imageSize, 0);
+    if (header.magic != MachMagic32 && header.magic != MachMagic64)
+        throw std::runtime_error("Not a Mach-O file");
+
+    bool is64Bit = header.magic == MachMagic64;
+    m_pointerSize = is64Bit ? 8 : 4;
+    uint64_t offset = sizeof(MachHeader) + (is64Bit ? 4 : 0);
+
+    bool haveImageBase = false;
+    std::optional<LinkEditDataCommand> fixupsCommand;
+
+    for (uint32_t i = 0; i < header.commandCount; ++i) {
+        auto command = load<LoadCommand>(m_image, m_imageSize, offset);
+        if (command.size < sizeof(LoadCommand))
+            throw std::runtime_error("Malformed load command");
+
+        if (command.command == LoadCommandSegment64 || command.command == LoadCommandSegment32) {
+            Segment segment;
+            uint32_t sectionCount;
+            uint64_t sectionOffset;
+
+            if (command.command == LoadCommandSegment64) {
+                auto sc = load<SegmentCommand64>(m_image, m_imageSize, offset);
+                segment = { sc.address, sc.addressSize, sc.fileOffset, sc.fileSize };
+                sectionCount = sc.sectionCount;
+                sectionOffset = offset + sizeof(SegmentCommand64);
+            } else {
+                auto sc = load<SegmentCommand32>(m_image, m_imageSize, offset);
+                segment = { sc.address, sc.addressSize, sc.fileOffset, sc.fileSize };
+                sectionCount = sc.sectionCount;
+                sectionOffset = offset + sizeof(SegmentCommand32);
+            }
+
+            // Clamp the file-backed portion of the segment to the image so
+            // reads can never run past the mapping.
+            if (segment.fileOffset > m_imageSize)
+                segment.fileSize = 0;
+            else
+                segment.fileSize = std::min<uint64_t>(segment.fileSize, m_imageSize - segment.fileOffset);
+
+            // Like BinaryView::GetStart, treat the first file-backed segment
+            // (normally __TEXT) as the image base; __PAGEZERO is skipped.
+            if (!haveImageBase && segment.fileSize > 0) {
+                m_imageBase = segment.address;
+                haveImageBase = true;
+            }
+
+            if (segment.size > 0)
+                m_segments.push_back(segment);
+
+            for (uint32_t s = 0; s < sectionCount; ++s) {
+                std::string segmentName;
+                std::string name;
+                SectionRange range;
+
+                if (command.command == LoadCommandSegment64) {
+                    auto section = load<Section64>(m_image, m_imageSize, sectionOffset + s * sizeof(Section64));
+                    segmentName = fixedString(section.segmentName);
+                    name = fixedString(section.name);
+                    range = { section.address, section.address + section.size };
+                } else {
+                    auto section = load<Section32>(m_image, m_imageSize, sectionOffset + s * sizeof(Section32));
+                    segmentName = fixedString(section.segmentName);
+                    name = fixedString(section.name);
+                    range = { section.address, section.address + section.size };
+                }
+
+                // Section names are only unique within a segment, e.g. both
+                // __DATA and __DATA_CONST may have an __objc_const section.
+                // The bare name resolves to the first one in load order.
+                m_sections[segmentName + "," + name] = range;
+                m_sections.emplace(name, range);
+            }
+        }
+
+        if (command.command == LoadCommandChainedFixups) {
+            fixupsCommand = load<LinkEditDataCommand>(m_image, m_imageSize, offset);
+        }
+
+        offset += command.size;
+    }
+
+    std::sort(m_segments.begin(), m_segments.end(),
+        [](const Segment& a, const Segment& b) { return a.address < b.address; });
+
+    // Chains are walked through the segments, so this has to come last.
+    if (fixupsCommand)
+        parseChainedFixups(fixupsCommand->dataOffset, fixupsCommand->dataSize);
+}
+
+void MachOFile::parseChainedFixups(uint64_t offset, uint64_t size)
+{
+    if (offset > m_imageSize || size > m_imageSize - offset)
+        return;
+
+    // Fixups only refine pointer decoding and import names; if they cannot be
+    // parsed, analysis falls back to decoding pointers heuristically.
+    try {
+        m_fixups = std::make_shared<const ChainedFixups>(*this, m_image + offset, size, m_imageBase);
+    } catch (const std::runtime_error&) {
+        m_fixups = nullptr;
+    }
+}
+
+const MachOFile::Segment* MachOFile::segmentForAddress(uint64_t address) const
+{
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), address,
+        [](uint64_t address, const Segment& segment) { return address < segment.address; });
+    if (it == m_segments.begin())
+        return nullptr;
+
+    --it;
+    if (address - it->address >= it->size)
+        return nullptr;
+
+    return &*it;
+}
+
+void MachOFile::seek(uint64_t address)
+{
+    m_offset = address;
+}
+
+uint64_t MachOFile::tell() const
+{
+    return m_offset;
+}
+
+uint8_t MachOFile::readByte()
+{
+    auto result = readStruct<uint8_t>(m_offset);
+    m_offset += sizeof(result);
+    return result;
+}
+
+uint32_t MachOFile::readInt()
+{
+    auto result = readStruct<uint32_t>(m_offset);
+    m_offset += sizeof(result);
+    return result;
+}
+
+uint64_t MachOFile::readLong()
+{
+    auto result = readStruct<uint64_t>(m_offset);
+    m_offset += sizeof(result);
+    return result;
+}
+
+size_t MachOFile::readBytes(uint64_t address, void* buffer, size_t length)
+{
+    auto segment = segmentForAddress(address);
+    if (!segment)
+        return 0;
+
+    // Reads are truncated at the end of the segment. Data past the end of the
+    // file-backed portion of a segment is zero-filled.
+    auto segmentOffset = address - segment->address;
+    length = static_cast<size_t>(std::min<uint64_t>(length, segment->size - segmentOffset));
+
+    size_t fileBacked = 0;
+    if (segmentOffset < segment->fileSize) {
+        fileBacked = static_cast<size_t>(std::min<uint64_t>(length, segment->fileSize - segmentOffset));
+        std::memcpy(buffer, m_image + segment->fileOffset + segmentOffset, fileBacked);
+    }
+
+    std::memset(static_cast<uint8_t*>(buffer) + fileBacked, 0, length - fileBacked);
+    return length;
+}
+
+size_t MachOFile::pointerSize() const
+{
+    return m_pointerSize;
+}
+
+uint64_t MachOFile::imageBase() const
+{
+    return m_imageBase;
+}
+
+uint64_t MachOFile::sectionStart(const std::string& name) const
+{
+    auto it = m_sections.find(name);
+    if (it == m_sections.end())
+        return 0;
+
+    return it->second.start;
+}
+
+uint64_t MachOFile::sectionEnd(const std::string& name) const
+{
+    auto it = m_sections.find(name);
+    if (it == m_sections.end())
+        return 0;
+
+    return it->second.end;
+}
+
+bool MachOFile::addressIsMapped(uint64_t address, bool) const
+{
+    // There is no synthetic extern section outside of a BinaryView, so every
+    // address inside a segment counts as mapped.
+    return segmentForAddress(address) != nullptr;
+}
+
+bool MachOFile::hasImportedSymbolAtLocation(uint64_t address) const
+{
+    if (!m_fixups)
+        return false;
+
+    auto fixup = m_fixups->find(address);
+    return fixup && fixup->isBind();
+}
+
+std::string MachOFile::symbolNameAtLocation(uint64_t address) const
+{
+    if (!m_fixups)
+        return "";
+
+    auto fixup = m_fixups->find(address);
+    if (!fixup)
+        return "";
+
+    return std::string(m_fixups->importName(*fixup));
+}
+
+const ChainedFixups* MachOFile::chainedFixups() const
+{
+    return m_fixups.get();
+}
+
+}
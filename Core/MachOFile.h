@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AbstractFile.h"
+#include "ChainedFixups.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * AbstractFile implementation backed by a memory-mapped Mach-O file on disk.
+ *
+ * Segment and section load commands are parsed directly from the mapping, and
+ * all reads are served from it without copying the file, which allows the
+ * structure analyzers to run without a BinaryView. For universal binaries,
+ * the first 64-bit slice is used.
+ *
+ * Reads return data as stored in the file; if the image uses chained fixups,
+ * they are exposed through chainedFixups() rather than applied, and binds
+ * are reported as imported symbols.
+ */
+class MachOFile : public ObjectiveNinja::AbstractFile {
+    struct Segment {
+        uint64_t address;
+        uint64_t size;
+        uint64_t fileOffset;
+        uint64_t fileSize;
+    };
+
+    struct SectionRange {
+        uint64_t start;
+        uint64_t end;
+    };
+
+    class Mapping;
+
+    std::shared_ptr<const Mapping> m_mapping;
+    std::shared_ptr<const ChainedFixups> m_fixups;
+
+    const uint8_t* m_image = nullptr;
+    size_t m_imageSize = 0;
+
+    std::vector<Segment> m_segments;
+
+    /**
+     * Sections keyed by both "segment,section" and the bare section name.
+     */
+    std::unordered_map<std::string, SectionRange> m_sections;
+    size_t m_pointerSize = 8;
+    uint64_t m_imageBase = 0;
+    uint64_t m_offset = 0;
+
+    /**
+     * Select the image to use, resolving universal binaries to a single slice.
+     */
+    void selectImage();
+
+    /**
+     * Parse the segment and section load commands of the selected image.
+     */
+    void parseLoadCommands();
+
+    /**
+     * Parse the chained fixups payload at the given offset in the image.
+     */
+    void parseChainedFixups(uint64_t offset, uint64_t size);
+
+    /**
+     * Find the segment containing the given address.
+     */
+    const Segment* segmentForAddress(uint64_t) const;
+
+    MachOFile(const MachOFile&) = default;
+
+public:
+    /**
+     * Map the Mach-O file at the given path. Throws std::runtime_error if the
+     * file cannot be mapped or is not a Mach-O.
+     */
+    explicit MachOFile(const std::string& path);
+    virtual ~MachOFile();
+
+    std::shared_ptr<AbstractFile> clone() const override;
+
+    void seek(uint64_t) override;
+    uint64_t tell() const override;
+
+    uint8_t readByte() override;
+    uint32_t readInt() override;
+    uint64_t readLong() override;
+    size_t readBytes(uint64_t offset, void* buffer, size_t length) override;
+
+    size_t pointerSize() const override;
+    uint64_t imageBase() const override;
+    uint64_t sectionStart(const std::string& name) const override;
+    uint64_t sectionEnd(const std::string& name) const override;
+
+    bool addressIsMapped(uint64_t address, bool includeExtern) const override;
+
+    bool hasImportedSymbolAtLocation(uint64_t address) const override;
+
+    std::string symbolNameAtLocation(uint64_t address) const override;
+
+    const ChainedFixups* chainedFixups() const override;
+};
+
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AnalysisInfo.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Blocking queue with a fixed capacity, for passing work between a producer
+ * and a consumer running at different speeds.
+ */
+template <typename T>
+class BoundedQueue {
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    size_t m_capacity;
+    bool m_closed = false;
+
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity(capacity)
+    {
+    }
+
+    /**
+     * Add an item, blocking while the queue is full. Returns false, dropping
+     * the item, if the queue has been closed.
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_closed || m_items.size() < m_capacity; });
+        if (m_closed)
+            return false;
+
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    /**
+     * Take the next item, blocking while the queue is empty. Returns nothing
+     * once the queue is closed and empty.
+     */
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return m_closed || !m_items.empty(); });
+        if (m_items.empty())
+            return std::nullopt;
+
+        auto item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    /**
+     * Check if the queue has been closed.
+     */
+    bool closed()
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        return m_closed;
+    }
+
+    /**
+     * Close the queue. Items already queued can still be taken, but no more
+     * can be added, and blocked producers and consumers are woken.
+     */
+    void close()
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+};
+
+/**
+ * Thrown by analysis once the consumer of its record queue has closed the
+ * queue early, such as when the user cancels analysis; there is no point in
+ * producing more records.
+ */
+class AnalysisCancelled : public std::runtime_error {
+public:
+    AnalysisCancelled()
+        : std::runtime_error("Analysis cancelled")
+    {
+    }
+};
+
+/**
+ * A single record emitted by an analyzer while streaming.
+ */
+using AnalysisRecord = std::variant<CFStringInfo, ClassInfo>;
+
+/**
+ * Queue of record batches, from the analyzers to the stage applying them.
+ */
+using RecordQueue = BoundedQueue<std::vector<AnalysisRecord>>;
+
+}
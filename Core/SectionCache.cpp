@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "SectionCache.h"
+
+#include <algorithm>
+
+namespace ObjectiveNinja {
+
+void SectionCache::add(uint64_t start, std::vector<uint8_t> data)
+{
+    if (data.empty())
+        return;
+
+    auto it = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), start,
+        [](uint64_t start, const Snapshot& snapshot) { return start < snapshot.start; });
+    m_snapshots.insert(it, { start, std::move(data) });
+}
+
+const uint8_t* SectionCache::find(uint64_t address, size_t length) const
+{
+    auto it = std::upper_bound(m_snapshots.begin(), m_snapshots.end(), address,
+        [](uint64_t address, const Snapshot& snapshot) { return address < snapshot.start; });
+
+    if (it != m_snapshots.begin()) {
+        const auto& snapshot = *std::prev(it);
+        auto offset = address - snapshot.start;
+
+        if (offset < snapshot.data.size() && length <= snapshot.data.size() - offset)
+            return snapshot.data.data() + offset;
+    }
+
+    return nullptr;
+}
+
+uint64_t SectionCache::bytes() const
+{
+    uint64_t bytes = 0;
+    for (const auto& snapshot : m_snapshots)
+        bytes += snapshot.data.size();
+
+    return bytes;
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * In-memory snapshots of address ranges (typically whole sections).
+ *
+ * The cache is filled once and is read-only afterwards, so it may be shared by
+ * readers on several threads. Hits and misses are counted by the readers
+ * themselves, to keep lookups free of shared writes.
+ */
+class SectionCache {
+    struct Snapshot {
+        uint64_t start;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<Snapshot> m_snapshots;
+
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t bytes;
+    };
+
+    /**
+     * Add a snapshot of the data starting at the given address. Snapshots
+     * must not overlap.
+     */
+    void add(uint64_t start, std::vector<uint8_t> data);
+
+    /**
+     * Get a pointer to `length` cached bytes starting at `address`, or null if
+     * the range is not entirely covered by a single snapshot.
+     */
+    const uint8_t* find(uint64_t address, size_t length) const;
+
+    /**
+     * Get the total size of all snapshots.
+     */
+    uint64_t bytes() const;
+};
+
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "SelectorTable.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace ObjectiveNinja {
+
+void SelectorTable::reserve(size_t count)
+{
+    m_addresses.reserve(count);
+    m_rawSelectors.reserve(count);
+    m_nameAddresses.reserve(count);
+    m_names.reserve(count);
+}
+
+void SelectorTable::add(uint64_t address, uint64_t rawSelector, uint64_t nameAddress, std::string_view name)
+{
+    m_addresses.push_back(address);
+    m_rawSelectors.push_back(rawSelector);
+    m_nameAddresses.push_back(nameAddress);
+    m_names.push_back(name);
+}
+
+static std::vector<uint32_t> sortedIndex(const std::vector<uint64_t>& column)
+{
+    std::vector<uint32_t> index(column.size());
+    std::iota(index.begin(), index.end(), 0);
+
+    // Stable, so that entries with equal keys stay in insertion order.
+    std::stable_sort(index.begin(), index.end(), [&](uint32_t a, uint32_t b) {
+        return column[a] < column[b];
+    });
+
+    return index;
+}
+
+void SelectorTable::buildIndices()
+{
+    m_byAddress = sortedIndex(m_addresses);
+    m_byRawSelector = sortedIndex(m_rawSelectors);
+}
+
+SelectorRefInfo SelectorTable::at(size_t index) const
+{
+    SelectorRefInfo info;
+    info.address = m_addresses[index];
+    info.name = m_names[index];
+    info.rawSelector = m_rawSelectors[index];
+    info.nameAddress = m_nameAddresses[index];
+
+    return info;
+}
+
+std::optional<size_t> SelectorTable::findIndex(const std::vector<uint32_t>& index,
+    const std::vector<uint64_t>& column, uint64_t key) const
+{
+    auto it = std::upper_bound(index.begin(), index.end(), key, [&](uint64_t value, uint32_t i) {
+        return value < column[i];
+    });
+
+    if (it == index.begin() || column[*(it - 1)] != key)
+        return std::nullopt;
+
+    return *(it - 1);
+}
+
+std::optional<SelectorRefInfo> SelectorTable::findByAddress(uint64_t address) const
+{
+    if (auto index = findIndex(m_byAddress, m_addresses, address))
+        return at(*index);
+
+    return std::nullopt;
+}
+
+std::optional<SelectorRefInfo> SelectorTable::findByRawSelector(uint64_t rawSelector) const
+{
+    if (auto index = findIndex(m_byRawSelector, m_rawSelectors, rawSelector))
+        return at(*index);
+
+    return std::nullopt;
+}
+
+size_t SelectorTable::bytes() const
+{
+    return (m_addresses.capacity() + m_rawSelectors.capacity() + m_nameAddresses.capacity()) * sizeof(uint64_t)
+        + m_names.capacity() * sizeof(std::string_view)
+        + (m_byAddress.capacity() + m_byRawSelector.capacity()) * sizeof(uint32_t);
+}
+
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * A description of a selector reference.
+ */
+struct SelectorRefInfo {
+    uint64_t address {};
+
+    std::string_view name {};
+
+    uint64_t rawSelector {};
+    uint64_t nameAddress {};
+};
+
+/**
+ * Columnar storage for selector references.
+ *
+ * Each field of SelectorRefInfo is kept in its own contiguous array, and
+ * lookups by address and by raw selector value go through separate sorted
+ * index arrays rather than per-entry allocations and a shared hash map.
+ *
+ * Entries are added with add(), after which buildIndices() must be called
+ * before any lookups are made.
+ */
+class SelectorTable {
+    std::vector<uint64_t> m_addresses;
+    std::vector<uint64_t> m_rawSelectors;
+    std::vector<uint64_t> m_nameAddresses;
+    std::vector<std::string_view> m_names;
+
+    /**
+     * Entry indices sorted by address and by raw selector, respectively.
+     */
+    std::vector<uint32_t> m_byAddress;
+    std::vector<uint32_t> m_byRawSelector;
+
+    /**
+     * Find the last entry added whose key in `column` matches, using the
+     * given sorted index.
+     */
+    std::optional<size_t> findIndex(const std::vector<uint32_t>& index,
+        const std::vector<uint64_t>& column, uint64_t key) const;
+
+public:
+    class Iterator {
+        const SelectorTable* m_table;
+        size_t m_index;
+
+    public:
+        Iterator(const SelectorTable* table, size_t index)
+            : m_table(table)
+            , m_index(index)
+        {
+        }
+
+        SelectorRefInfo operator*() const { return m_table->at(m_index); }
+        Iterator& operator++()
+        {
+            ++m_index;
+            return *this;
+        }
+        bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+    };
+
+    /**
+     * Reserve space for the given number of entries.
+     */
+    void reserve(size_t);
+
+    /**
+     * Add a selector reference.
+     */
+    void add(uint64_t address, uint64_t rawSelector, uint64_t nameAddress, std::string_view name);
+
+    /**
+     * Build the lookup indices. Must be called after the last entry is added.
+     */
+    void buildIndices();
+
+    size_t size() const { return m_addresses.size(); }
+    bool empty() const { return m_addresses.empty(); }
+
+    /**
+     * Get the entry at the given index.
+     */
+    SelectorRefInfo at(size_t) const;
+
+    Iterator begin() const { return { this, 0 }; }
+    Iterator end() const { return { this, size() }; }
+
+    /**
+     * Find the selector reference at the given address.
+     */
+    std::optional<SelectorRefInfo> findByAddress(uint64_t) const;
+
+    /**
+     * Find the selector reference with the given raw (undecoded) selector
+     * value. If several references share a value, the last one is returned.
+     */
+    std::optional<SelectorRefInfo> findByRawSelector(uint64_t) const;
+
+    /**
+     * Get the number of bytes used by the table's arrays.
+     */
+    size_t bytes() const;
+};
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "SharedCacheTables.h"
+
+#include "AnalysisInfo.h"
+
+#include <mutex>
+
+namespace ObjectiveNinja {
+
+bool SharedCacheTables::claimImage(const std::string& name)
+{
+    std::unique_lock lock(m_mutex);
+    return m_images.insert(name).second;
+}
+
+void SharedCacheTables::releaseImage(const std::string& name)
+{
+    std::unique_lock lock(m_mutex);
+    m_images.erase(name);
+}
+
+void SharedCacheTables::addClasses(const std::vector<ClassInfo>& classes)
+{
+    // Names are copied into the shared pool, since they may be views into
+    // storage owned by the image's own AnalysisInfo.
+    std::unique_lock lock(m_mutex);
+    for (const auto& ci : classes) {
+        m_classNames.emplace(ci.address, m_strings.intern(ci.name));
+        if (ci.metaClassInfo)
+            m_classNames.emplace(ci.metaClassInfo->info.address, m_strings.intern(ci.metaClassInfo->name));
+    }
+}
+
+std::optional<std::string_view> SharedCacheTables::className(uint64_t address) const
+{
+    std::shared_lock lock(m_mutex);
+    auto it = m_classNames.find(address);
+    if (it == m_classNames.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+size_t SharedCacheTables::classCount() const
+{
+    std::shared_lock lock(m_mutex);
+    return m_classNames.size();
+}
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "StringPool.h"
+
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+struct ClassInfo;
+
+/**
+ * Tables shared by the analyses of all images loaded from one dyld shared
+ * cache.
+ *
+ * Images in a shared cache reference each other's selector strings and
+ * classes. Sharing a string pool means a string is read once no matter how
+ * many images reference it, and the class table lets references to classes
+ * in other images be resolved by name.
+ *
+ * All methods are thread-safe, so images may be analyzed concurrently.
+ */
+class SharedCacheTables {
+    StringPool m_strings;
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<uint64_t, std::string_view> m_classNames;
+    std::unordered_set<std::string> m_images;
+
+public:
+    /**
+     * Get the string pool shared by all images.
+     */
+    StringPool& strings() { return m_strings; }
+
+    /**
+     * Claim an image for analysis. Returns false if the image has already
+     * been claimed, in which case it should not be analyzed again.
+     */
+    bool claimImage(const std::string& name);
+
+    /**
+     * Release the claim on an image whose analysis failed, so that it can be
+     * claimed and analyzed again later.
+     */
+    void releaseImage(const std::string& name);
+
+    /**
+     * Add the classes found in an image to the class table.
+     */
+    void addClasses(const std::vector<ClassInfo>&);
+
+    /**
+     * Get the name of the class at the given address, in any image.
+     */
+    std::optional<std::string_view> className(uint64_t address) const;
+
+    /**
+     * Get the number of classes in the class table.
+     */
+    size_t classCount() const;
+};
+
+}
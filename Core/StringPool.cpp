@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "StringPool.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace ObjectiveNinja {
+
+std::string_view StringPool::store(std::string_view text)
+{
+    // Strings are stored null-terminated so that views can also be passed to
+    // C-style APIs via data().
+    auto length = text.size() + 1;
+
+    if (length > m_remaining) {
+        // Oversized strings get a dedicated block so the current block can
+        // continue to be filled.
+        if (length > BlockSize / 4) {
+            m_blocks.emplace_back(new char[length]);
+            auto data = m_blocks.back().get();
+            std::memcpy(data, text.data(), text.size());
+            data[text.size()] = 0;
+
+            m_bytes += length;
+            return { data, text.size() };
+        }
+
+        m_blocks.emplace_back(new char[BlockSize]);
+        m_cursor = m_blocks.back().get();
+        m_remaining = BlockSize;
+    }
+
+    auto data = m_cursor;
+    std::memcpy(data, text.data(), text.size());
+    data[text.size()] = 0;
+
+    m_cursor += length;
+    m_remaining -= length;
+    m_bytes += length;
+    return { data, text.size() };
+}
+
+std::string_view StringPool::intern(std::string_view text)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        if (auto it = m_strings.find(text); it != m_strings.end())
+            return *it;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+
+    // Another thread may have added the string between the two locks.
+    if (auto it = m_strings.find(text); it != m_strings.end())
+        return *it;
+
+    auto stored = store(text);
+    m_strings.insert(stored);
+    return stored;
+}
+
+std::string_view StringPool::intern(uint64_t address, std::string_view text)
+{
+    auto result = intern(text);
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_byAddress.emplace(address, result);
+
+    return result;
+}
+
+std::optional<std::string_view> StringPool::find(uint64_t address) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    auto it = m_byAddress.find(address);
+    if (it == m_byAddress.end())
+        return std::nullopt;
+
+    return it->second;
+}
+
+size_t StringPool::size() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_strings.size();
+}
+
+size_t StringPool::bytes() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    return m_bytes;
+}
+
+}
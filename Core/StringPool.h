@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Deduplicating string storage.
+ *
+ * Strings are copied into large arena blocks exactly once per unique content
+ * and handed out as views, which remain valid for the lifetime of the pool.
+ * Strings read from the binary can additionally be recorded by address so
+ * repeated reads of the same address are free.
+ *
+ * All methods are thread-safe, so analyzers running concurrently may share a
+ * single pool.
+ */
+class StringPool {
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> m_blocks;
+    char* m_cursor = nullptr;
+    size_t m_remaining = 0;
+    size_t m_bytes = 0;
+
+    mutable std::shared_mutex m_mutex;
+    std::unordered_set<std::string_view> m_strings;
+    std::unordered_map<uint64_t, std::string_view> m_byAddress;
+
+    /**
+     * Copy a string into arena storage, returning a view of the copy.
+     */
+    std::string_view store(std::string_view);
+
+public:
+    StringPool() = default;
+
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    /**
+     * Get the pooled copy of a string, adding it if not already present.
+     */
+    std::string_view intern(std::string_view);
+
+    /**
+     * Intern a string and record it as the string found at `address`.
+     */
+    std::string_view intern(uint64_t address, std::string_view);
+
+    /**
+     * Get the string previously recorded at `address`, if any.
+     */
+    std::optional<std::string_view> find(uint64_t address) const;
+
+    /**
+     * Get the number of unique strings in the pool.
+     */
+    size_t size() const;
+
+    /**
+     * Get the number of bytes of string data stored, including terminators.
+     */
+    size_t bytes() const;
+};
+
+}
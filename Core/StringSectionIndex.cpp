@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "StringSectionIndex.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define OBJECTIVENINJA_SSE2 1
+#if defined(__GNUC__) && !defined(_MSC_VER)
+#include <immintrin.h>
+#define OBJECTIVENINJA_AVX2 1
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OBJECTIVENINJA_NEON 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace ObjectiveNinja {
+
+namespace {
+
+/**
+ * Number of bytes covered by each word of the terminator bitmap.
+ */
+constexpr size_t BlockSize = 64;
+
+unsigned countTrailingZeros(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#endif
+}
+
+uint64_t terminatorMaskScalar(const char* block, size_t length)
+{
+    uint64_t mask = 0;
+    for (size_t i = 0; i < length; ++i)
+        if (block[i] == '\0')
+            mask |= uint64_t(1) << i;
+
+    return mask;
+}
+
+#if OBJECTIVENINJA_SSE2
+uint64_t terminatorMaskSSE2(const char* block)
+{
+    const auto zero = _mm_setzero_si128();
+
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+        auto bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero)));
+        mask |= uint64_t(bits) << (i * 16);
+    }
+
+    return mask;
+}
+#endif
+
+#if OBJECTIVENINJA_AVX2
+__attribute__((target("avx2"))) uint64_t terminatorMaskAVX2(const char* block)
+{
+    const auto zero = _mm256_setzero_si256();
+
+    auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    auto loBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, zero)));
+    auto hiBits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, zero)));
+
+    return uint64_t(loBits) | (uint64_t(hiBits) << 32);
+}
+#endif
+
+#if OBJECTIVENINJA_NEON
+uint64_t terminatorMaskNEON(const char* block)
+{
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const auto bitWeights = vld1q_u8(weights);
+
+    uint64_t mask = 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        auto chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(block + i * 16));
+        auto weighted = vandq_u8(vceqq_u8(chunk, vdupq_n_u8(0)), bitWeights);
+        uint64_t bits = vaddv_u8(vget_low_u8(weighted)) | (vaddv_u8(vget_high_u8(weighted)) << 8);
+        mask |= bits << (i * 16);
+    }
+
+    return mask;
+}
+#endif
+
+using BlockScanner = uint64_t (*)(const char*);
+
+/**
+ * Pick the widest block scanner supported by the running CPU.
+ */
+BlockScanner blockScanner()
+{
+#if OBJECTIVENINJA_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return terminatorMaskAVX2;
+#endif
+#if OBJECTIVENINJA_SSE2
+    return terminatorMaskSSE2;
+#elif OBJECTIVENINJA_NEON
+    return terminatorMaskNEON;
+#else
+    return [](const char* block) { return terminatorMaskScalar(block, BlockSize); };
+#endif
+}
+
+}
+
+const std::vector<std::string> StringSectionIndex::IndexedSections = {
+    "__objc_methname",
+    "__objc_methtype",
+    "__objc_classname",
+};
+
+std::shared_ptr<const StringSectionIndex> StringSectionIndex::build(AbstractFile& file)
+{
+    auto index = std::make_shared<StringSectionIndex>();
+
+    for (const auto& name : IndexedSections) {
+        auto start = file.sectionStart(name);
+        auto end = file.sectionEnd(name);
+        if (start == 0 || end <= start)
+            continue;
+
+        std::vector<char> data(end - start);
+        data.resize(file.readBytes(start, data.data(), data.size()));
+
+        index->add(start, std::move(data));
+    }
+
+    return index;
+}
+
+void StringSectionIndex::add(uint64_t start, std::vector<char> data)
+{
+    if (data.empty())
+        return;
+
+    static const auto scanBlock = blockScanner();
+
+    const auto fullBlocks = data.size() / BlockSize;
+    const auto tail = data.size() % BlockSize;
+
+    std::vector<uint64_t> terminators(fullBlocks + (tail ? 1 : 0));
+    for (size_t i = 0; i < fullBlocks; ++i)
+        terminators[i] = scanBlock(data.data() + i * BlockSize);
+    if (tail)
+        terminators[fullBlocks] = terminatorMaskScalar(data.data() + fullBlocks * BlockSize, tail);
+
+    auto it = std::upper_bound(m_sections.begin(), m_sections.end(), start,
+        [](uint64_t start, const Section& section) { return start < section.start; });
+    m_sections.insert(it, { start, std::move(data), std::move(terminators) });
+}
+
+std::optional<std::string_view> StringSectionIndex::stringAt(uint64_t address) const
+{
+    auto it = std::upper_bound(m_sections.begin(), m_sections.end(), address,
+        [](uint64_t address, const Section& section) { return address < section.start; });
+    if (it == m_sections.begin())
+        return std::nullopt;
+
+    const auto& section = *std::prev(it);
+    const auto offset = address - section.start;
+    if (offset >= section.data.size())
+        return std::nullopt;
+
+    // Ignore terminators before the string's start within its first block,
+    // then advance to the first block containing a terminator.
+    auto block = offset / BlockSize;
+    auto mask = section.terminators[block] & (~uint64_t(0) << (offset % BlockSize));
+    while (mask == 0) {
+        if (++block == section.terminators.size())
+            return std::nullopt;
+
+        mask = section.terminators[block];
+    }
+
+    const auto end = block * BlockSize + countTrailingZeros(mask);
+    return std::string_view(section.data.data() + offset, end - offset);
+}
+
+size_t StringSectionIndex::bytes() const
+{
+    size_t total = 0;
+    for (const auto& section : m_sections)
+        total += section.data.capacity() + section.terminators.capacity() * sizeof(uint64_t);
+
+    return total;
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "AbstractFile.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Pre-indexed copies of the C-string sections holding selectors, method type
+ * encodings and class names.
+ *
+ * Each section is read in a single bulk read and scanned once for NUL
+ * terminators, using SIMD where available. The result is a bitmap with one
+ * bit per byte, marking terminators; the length of the string at any offset
+ * is then found by looking at (usually) a single 64-bit word of the bitmap.
+ * Strings are returned as views into the section copy, so the index must
+ * outlive any views obtained from it.
+ *
+ * The index is immutable once built and may be shared between threads.
+ */
+class StringSectionIndex {
+    struct Section {
+        uint64_t start;
+        std::vector<char> data;
+        std::vector<uint64_t> terminators;
+    };
+
+    std::vector<Section> m_sections;
+
+    /**
+     * Add a copy of a section and index its terminators.
+     */
+    void add(uint64_t start, std::vector<char> data);
+
+public:
+    static const std::vector<std::string> IndexedSections;
+
+    /**
+     * Build an index of the string sections present in the given file.
+     */
+    static std::shared_ptr<const StringSectionIndex> build(AbstractFile&);
+
+    /**
+     * Get the string starting at the given address, or std::nullopt if the
+     * address is outside of the indexed sections, or the string is not
+     * terminated before the end of its section.
+     */
+    std::optional<std::string_view> stringAt(uint64_t address) const;
+
+    /**
+     * Get the total size of the section copies and bitmaps.
+     */
+    size_t bytes() const;
+};
+
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace ObjectiveNinja {
+
+/**
+ * The pool and worker index of the current thread, if it is a pool worker.
+ */
+static thread_local const ThreadPool* t_currentPool = nullptr;
+static thread_local unsigned t_currentIndex = 0;
+
+ThreadPool::ThreadPool(unsigned workerCount)
+{
+    if (workerCount == 0)
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+
+    m_queues.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_queues.push_back(std::make_unique<WorkerQueue>());
+
+    m_workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i)
+        m_workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_available.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+unsigned ThreadPool::currentWorkerIndex() const
+{
+    return t_currentPool == this ? t_currentIndex : workerCount();
+}
+
+std::function<void()> ThreadPool::takeTask(size_t preferredQueue)
+{
+    const auto queueCount = m_queues.size();
+
+    for (size_t i = 0; i < queueCount; ++i) {
+        auto& queue = *m_queues[(preferredQueue + i) % queueCount];
+
+        std::scoped_lock<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        // Own work is taken from the front to keep batch order; stolen work
+        // is taken from the back, away from where the owner is working.
+        std::function<void()> task;
+        if (i == 0) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        } else {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+
+        --m_pending;
+        return task;
+    }
+
+    return {};
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+    t_currentPool = this;
+    t_currentIndex = static_cast<unsigned>(index);
+
+    while (true) {
+        if (auto task = takeTask(index)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_available.wait(lock, [this] { return m_stopping || m_pending > 0; });
+
+        if (m_stopping && m_pending == 0)
+            return;
+    }
+}
+
+void ThreadPool::runAll(std::vector<std::function<void()>> tasks)
+{
+    struct Batch {
+        std::mutex mutex;
+        std::condition_variable done;
+        size_t remaining;
+        std::vector<std::exception_ptr> errors;
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->remaining = tasks.size();
+    batch->errors.resize(tasks.size());
+
+    const auto firstQueue = m_nextQueue.fetch_add(1);
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        auto& queue = *m_queues[(firstQueue + i) % m_queues.size()];
+
+        std::scoped_lock<std::mutex> lock(queue.mutex);
+        queue.tasks.emplace_back([batch, i, task = std::move(tasks[i])] {
+            try {
+                task();
+            } catch (...) {
+                batch->errors[i] = std::current_exception();
+            }
+
+            std::scoped_lock<std::mutex> lock(batch->mutex);
+            if (--batch->remaining == 0)
+                batch->done.notify_all();
+        });
+        ++m_pending;
+    }
+
+    {
+        // Taking the lock orders the pending count update before any worker
+        // re-checks it, so no wakeup is lost.
+        std::scoped_lock<std::mutex> lock(m_mutex);
+    }
+    m_available.notify_all();
+
+    // Help drain the queues rather than sitting idle. Tasks from other batches
+    // may be picked up here too, which is harmless.
+    const auto ownQueue = currentWorkerIndex() % m_queues.size();
+    while (auto task = takeTask(ownQueue))
+        task();
+
+    {
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->done.wait(lock, [&] { return batch->remaining == 0; });
+    }
+
+    for (const auto& error : batch->errors)
+        if (error)
+            std::rethrow_exception(error);
+}
+
+}
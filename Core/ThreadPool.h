@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ObjectiveNinja {
+
+/**
+ * Fixed-size, work-stealing pool of worker threads for running analysis tasks.
+ *
+ * Every worker owns a task queue. Batches are spread across the queues, and
+ * a worker that runs out of work steals from the back of another worker's
+ * queue, so uneven tasks (such as class list chunks containing a few huge
+ * classes) do not leave workers idle.
+ */
+class ThreadPool {
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_available;
+    std::atomic<size_t> m_pending { 0 };
+    std::atomic<size_t> m_nextQueue { 0 };
+    bool m_stopping = false;
+
+    /**
+     * Take a task, preferring the front of the given worker's own queue and
+     * otherwise stealing from the back of another queue. Returns an empty
+     * function if all queues are empty.
+     */
+    std::function<void()> takeTask(size_t preferredQueue);
+
+    void workerLoop(size_t index);
+
+public:
+    /**
+     * Create a pool with the given number of workers. If zero, the number of
+     * hardware threads is used.
+     */
+    explicit ThreadPool(unsigned workerCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Get the number of worker threads.
+     */
+    unsigned workerCount() const { return static_cast<unsigned>(m_workers.size()); }
+
+    /**
+     * Get the index of the calling thread within this pool, in the range
+     * [0, workerCount()). Threads outside of the pool get workerCount().
+     *
+     * Within a single runAll() batch, no two threads share an index, which
+     * makes it suitable for indexing per-worker state.
+     */
+    unsigned currentWorkerIndex() const;
+
+    /**
+     * Run all tasks and wait for them to finish. The calling thread helps run
+     * queued tasks while waiting, so this may also be called from within a
+     * task running on the pool. If any task throws, the first exception (in
+     * task order) is rethrown once all tasks have finished.
+     */
+    void runAll(std::vector<std::function<void()>> tasks);
+};
+
+}
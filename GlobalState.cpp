@@ -7,22 +7,208 @@
 
 #include "GlobalState.h"
 
-#include <set>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 
-static std::unordered_map<BinaryViewID, SharedAnalysisInfo> g_analysisRecords;
-static std::unordered_map<BinaryViewID, MessageHandler*> g_messageHandlers;
-static std::set<BinaryViewID> g_ignoredViews;
+/**
+ * Notification listener that marks a view whenever a section is added.
+ */
+class SectionObserver : public BinaryNinja::BinaryDataNotification {
+public:
+    /**
+     * Shared with the view's snapshots.
+     */
+    std::shared_ptr<std::atomic<bool>> changed = std::make_shared<std::atomic<bool>>(true);
+
+    /**
+     * Number of sections added since the observer was registered; unlike
+     * `changed`, never reset.
+     */
+    std::atomic<uint64_t> additions { 0 };
+
+    void OnSectionAdded(BinaryNinja::BinaryView*, BinaryNinja::Section*) override
+    {
+        ++additions;
+        *changed = true;
+    }
+};
+
+/**
+ * Everything held in memory for a view.
+ */
+struct ViewState {
+    std::string name;
+
+    bool hasInfo = false;
+    SharedAnalysisInfo info;
+
+    /**
+     * Set when the info has been evicted to stay under the resident view
+     * limit; cleared once it is stored again.
+     */
+    bool evicted = false;
+
+    /**
+     * Value of the use counter when the view's info was last accessed.
+     * Shared with the view's snapshots, which update it without locking.
+     */
+    std::shared_ptr<std::atomic<uint64_t>> lastUse = std::make_shared<std::atomic<uint64_t>>(0);
+
+    std::shared_ptr<const MessageHandler> messageHandler;
+    bool ignored = false;
+
+    /**
+     * Serializes structure analysis of the view; see analysisMutex().
+     */
+    std::shared_ptr<std::mutex> analysisMutex = std::make_shared<std::mutex>();
+
+    std::shared_ptr<ObjectiveNinja::SharedCacheTables> sharedCacheTables;
+    std::vector<SharedAnalysisInfo> imageInfos;
+    std::unique_ptr<SectionObserver> sectionObserver;
+
+    /**
+     * CFString section ranges, and the sections version (see
+     * sectionsVersion()) they were built at.
+     */
+    std::shared_ptr<const SectionRanges> cfStringRanges;
+    uint64_t cfStringRangesVersion = 0;
+};
+
+/**
+ * Frees a view's state once the file it was opened from is destroyed.
+ */
+class ViewStateDestructor : public BinaryNinja::ObjectDestructor {
+public:
+    void DestructFileMetadata(BinaryNinja::FileMetadata* file) override { GlobalState::forgetView(file->GetSessionId()); }
+};
+
+using SnapshotTable = std::unordered_map<BinaryViewID, std::shared_ptr<const ViewSnapshot>>;
+
+/**
+ * Guards `g_views` and publishing snapshots; never taken by readers of
+ * snapshots.
+ */
+static std::mutex g_mutex;
+static std::unordered_map<BinaryViewID, ViewState> g_views;
+
+/**
+ * Snapshots of every view, replaced as a whole whenever one changes. Only
+ * accessed through std::atomic_load() and std::atomic_store().
+ */
+static std::shared_ptr<const SnapshotTable> g_snapshots = std::make_shared<const SnapshotTable>();
 
-MessageHandler* GlobalState::messageHandler(BinaryViewRef bv)
+static std::atomic<uint64_t> g_useCounter { 0 };
+
+/**
+ * Get the state for a view, creating it if needed. Must be called with the
+ * lock held.
+ */
+static ViewState& viewState(BinaryViewID id)
+{
+    return g_views[id];
+}
+
+/**
+ * Mark a view's info as used.
+ */
+static void touch(std::atomic<uint64_t>& lastUse)
 {
-    if (auto messageHandler = g_messageHandlers.find(id(bv)); messageHandler != g_messageHandlers.end()) {
-        return messageHandler->second;
+    lastUse.store(++g_useCounter, std::memory_order_relaxed);
+}
+
+/**
+ * Publish a new snapshot of a view's state, or remove the view's snapshot if
+ * `state` is null. Must be called with the lock held.
+ */
+static void publish(BinaryViewID viewId, const ViewState* state)
+{
+    auto table = std::make_shared<SnapshotTable>(*std::atomic_load(&g_snapshots));
+
+    if (state) {
+        auto snapshot = std::make_shared<ViewSnapshot>();
+        if (state->info)
+            snapshot->infos.push_back(state->info);
+        for (const auto& info : state->imageInfos)
+            if (info)
+                snapshot->infos.push_back(info);
+        snapshot->hasInfo = state->hasInfo;
+        snapshot->messageHandler = state->messageHandler;
+        snapshot->ignored = state->ignored;
+        if (state->sectionObserver)
+            snapshot->sectionsChanged = state->sectionObserver->changed;
+        snapshot->lastUse = state->lastUse;
+
+        (*table)[viewId] = std::move(snapshot);
     } else {
-        auto newMessageHandler = new MessageHandler(bv);
-        g_messageHandlers[id(bv)] = newMessageHandler;
-        return newMessageHandler;
+        table->erase(viewId);
+    }
+
+    std::atomic_store(&g_snapshots, std::shared_ptr<const SnapshotTable>(std::move(table)));
+}
+
+/**
+ * Get the current snapshot of a view, or null if it has none.
+ */
+static std::shared_ptr<const ViewSnapshot> currentSnapshot(BinaryViewID viewId)
+{
+    auto table = std::atomic_load(&g_snapshots);
+    auto it = table->find(viewId);
+    return it != table->end() ? it->second : nullptr;
+}
+
+void GlobalState::registerLifecycleHooks()
+{
+    // Intentionally leaked; it must outlive every view.
+    static auto* destructor = new ViewStateDestructor;
+    (void)destructor;
+}
+
+void GlobalState::forgetView(BinaryViewID viewId)
+{
+    // Destroyed outside the lock, as infos can be large. The view is already
+    // gone, so its section observer needs no unregistering.
+    ViewState state;
+    {
+        std::scoped_lock<std::mutex> lock(g_mutex);
+        auto it = g_views.find(viewId);
+        if (it == g_views.end())
+            return;
+
+        state = std::move(it->second);
+        g_views.erase(it);
+        publish(viewId, nullptr);
+    }
+}
+
+std::shared_ptr<const ViewSnapshot> GlobalState::snapshot(BinaryViewRef bv)
+{
+    auto snapshot = currentSnapshot(id(std::move(bv)));
+    if (snapshot && !snapshot->infos.empty())
+        touch(*snapshot->lastUse);
+
+    return snapshot;
+}
+
+std::shared_ptr<const MessageHandler> GlobalState::messageHandler(BinaryViewRef bv)
+{
+    const auto viewId = id(bv);
+    if (auto snapshot = currentSnapshot(viewId); snapshot && snapshot->messageHandler)
+        return snapshot->messageHandler;
+
+    // Finding the message send functions can take a while, so it is done
+    // without holding the lock.
+    auto created = std::make_shared<const MessageHandler>(bv);
+
+    std::scoped_lock<std::mutex> lock(g_mutex);
+    auto& state = viewState(viewId);
+    if (!state.messageHandler) {
+        state.messageHandler = std::move(created);
+        publish(viewId, &state);
     }
+
+    return state.messageHandler;
 }
 
 BinaryViewID GlobalState::id(BinaryViewRef bv)
@@ -32,30 +218,253 @@ BinaryViewID GlobalState::id(BinaryViewRef bv)
 
 void GlobalState::storeAnalysisInfo(BinaryViewRef bv, SharedAnalysisInfo records)
 {
-    g_analysisRecords[id(std::move(bv))] = std::move(records);
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    const auto viewId = id(bv);
+    auto& state = viewState(viewId);
+    state.name = bv->GetFile()->GetFilename();
+    state.hasInfo = true;
+    state.info = std::move(records);
+    state.evicted = false;
+    touch(*state.lastUse);
+
+    publish(viewId, &state);
 }
 
 SharedAnalysisInfo GlobalState::analysisInfo(BinaryViewRef bv)
 {
-    if (hasAnalysisInfo(bv))
-        return g_analysisRecords[id(bv)];
+    std::scoped_lock<std::mutex> lock(g_mutex);
 
-    return nullptr;
+    auto it = g_views.find(id(std::move(bv)));
+    if (it == g_views.end() || !it->second.hasInfo)
+        return nullptr;
+
+    touch(*it->second.lastUse);
+    return it->second.info;
 }
 
 bool GlobalState::hasAnalysisInfo(BinaryViewRef bv)
 {
-    return g_analysisRecords.count(id(std::move(bv))) > 0;
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    auto it = g_views.find(id(std::move(bv)));
+    return it != g_views.end() && it->second.hasInfo;
+}
+
+bool GlobalState::wasEvicted(BinaryViewRef bv)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    auto it = g_views.find(id(std::move(bv)));
+    return it != g_views.end() && it->second.evicted;
+}
+
+std::shared_ptr<std::mutex> GlobalState::analysisMutex(BinaryViewRef bv)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+    return viewState(id(std::move(bv))).analysisMutex;
+}
+
+void GlobalState::limitResidentViews(size_t maxViews)
+{
+    if (maxViews == 0)
+        return;
+
+    // Freed outside the lock, as with forgetView().
+    std::vector<SharedAnalysisInfo> evicted;
+    {
+        std::scoped_lock<std::mutex> lock(g_mutex);
+
+        // Shared cache views are never evicted, since their images would be
+        // analyzed and applied again. Neither are views whose method lists
+        // are still deferred, as their methods have yet to be applied.
+        std::vector<std::pair<uint64_t, BinaryViewID>> candidates;
+        for (auto& [viewId, state] : g_views)
+            if (state.info && !state.sharedCacheTables && !state.info->hasDeferredMethods())
+                candidates.emplace_back(state.lastUse->load(std::memory_order_relaxed), viewId);
+
+        if (candidates.size() <= maxViews)
+            return;
+
+        std::sort(candidates.begin(), candidates.end());
+
+        for (size_t i = 0; i < candidates.size() - maxViews; ++i) {
+            const auto viewId = candidates[i].second;
+            auto& state = g_views[viewId];
+            evicted.push_back(std::move(state.info));
+            state.info = nullptr;
+            state.hasInfo = false;
+            state.evicted = true;
+
+            publish(viewId, &state);
+        }
+    }
+}
+
+std::shared_ptr<ObjectiveNinja::SharedCacheTables> GlobalState::sharedCacheTables(BinaryViewRef bv)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    auto& tables = viewState(id(std::move(bv))).sharedCacheTables;
+    if (!tables)
+        tables = std::make_shared<ObjectiveNinja::SharedCacheTables>();
+
+    return tables;
+}
+
+void GlobalState::addImageAnalysisInfo(BinaryViewRef bv, SharedAnalysisInfo info)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    const auto viewId = id(std::move(bv));
+    auto& state = viewState(viewId);
+    state.imageInfos.push_back(std::move(info));
+
+    publish(viewId, &state);
+}
+
+std::vector<SharedAnalysisInfo> GlobalState::allAnalysisInfo(BinaryViewRef bv)
+{
+    if (auto snapshot = GlobalState::snapshot(std::move(bv)))
+        return snapshot->infos;
+
+    return {};
+}
+
+std::vector<ViewAnalysisInfo> GlobalState::analyzedViews()
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    std::vector<ViewAnalysisInfo> result;
+    for (const auto& [viewId, state] : g_views) {
+        if (!state.hasInfo && state.imageInfos.empty())
+            continue;
+
+        ViewAnalysisInfo view;
+        view.name = state.name;
+        if (state.info)
+            view.infos.push_back(state.info);
+        for (const auto& info : state.imageInfos)
+            if (info)
+                view.infos.push_back(info);
+        view.sharedTables = state.sharedCacheTables;
+
+        result.push_back(std::move(view));
+    }
+
+    return result;
+}
+
+void GlobalState::watchSections(BinaryViewRef bv)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    const auto viewId = id(bv);
+    auto& state = viewState(viewId);
+    if (state.sectionObserver)
+        return;
+
+    state.sectionObserver = std::make_unique<SectionObserver>();
+    bv->RegisterNotification(state.sectionObserver.get());
+
+    publish(viewId, &state);
+}
+
+bool GlobalState::takeSectionsChanged(BinaryViewRef bv)
+{
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    auto it = g_views.find(id(std::move(bv)));
+    if (it == g_views.end() || !it->second.sectionObserver)
+        return false;
+
+    return it->second.sectionObserver->changed->exchange(false);
+}
+
+/**
+ * Get a number that changes whenever sections are added to a watched view.
+ * Watching sections changes it as well, since sections may have been added
+ * before. Must be called with the lock held.
+ */
+static uint64_t sectionsVersion(const ViewState& state)
+{
+    return state.sectionObserver ? state.sectionObserver->additions.load() + 1 : 0;
+}
+
+std::shared_ptr<const SectionRanges> GlobalState::cfStringRanges(BinaryViewRef bv)
+{
+    const auto viewId = id(bv);
+    uint64_t version;
+    {
+        std::scoped_lock<std::mutex> lock(g_mutex);
+        auto& state = viewState(viewId);
+        version = sectionsVersion(state);
+        if (state.cfStringRanges && state.cfStringRangesVersion == version)
+            return state.cfStringRanges;
+    }
+
+    // Built without holding the lock, as listing sections goes through the
+    // core. Shared cache images have their sections prefixed with the image
+    // name.
+    auto ranges = std::make_shared<SectionRanges>();
+    for (const auto& section : bv->GetSections()) {
+        const auto name = section->GetName();
+        if (name.size() >= 10 && name.compare(name.size() - 10, 10, "__cfstring") == 0)
+            ranges->ranges.push_back({ section->GetStart(), section->GetStart() + section->GetLength() });
+    }
+    std::sort(ranges->ranges.begin(), ranges->ranges.end(),
+        [](const auto& a, const auto& b) { return a.start < b.start; });
+
+    std::scoped_lock<std::mutex> lock(g_mutex);
+    auto& state = viewState(viewId);
+    if (!state.cfStringRanges || state.cfStringRangesVersion <= version) {
+        state.cfStringRanges = ranges;
+        state.cfStringRangesVersion = version;
+    }
+
+    return ranges;
 }
 
 void GlobalState::addIgnoredView(BinaryViewRef bv)
 {
-    g_ignoredViews.insert(id(std::move(bv)));
+    std::scoped_lock<std::mutex> lock(g_mutex);
+
+    const auto viewId = id(std::move(bv));
+    auto& state = viewState(viewId);
+    state.ignored = true;
+
+    publish(viewId, &state);
 }
 
 bool GlobalState::viewIsIgnored(BinaryViewRef bv)
 {
-    return g_ignoredViews.count(id(std::move(bv))) > 0;
+    auto snapshot = currentSnapshot(id(std::move(bv)));
+    return snapshot && snapshot->ignored;
+}
+
+bool GlobalState::hasSavedAnalysisInfo(BinaryViewRef bv, const std::string& cacheKey)
+{
+    // The info is only valid for the contents it was produced from.
+    auto savedKey = bv->QueryMetadata(MetadataKey::AnalysisInfoCacheKey);
+    return savedKey && savedKey->IsString() && savedKey->GetString() == cacheKey;
+}
+
+std::vector<uint8_t> GlobalState::savedAnalysisInfo(BinaryViewRef bv, const std::string& cacheKey)
+{
+    if (!hasSavedAnalysisInfo(bv, cacheKey))
+        return {};
+
+    auto data = bv->QueryMetadata(MetadataKey::AnalysisInfo);
+    if (!data || !data->IsRaw())
+        return {};
+
+    return data->GetRaw();
+}
+
+void GlobalState::saveAnalysisInfo(BinaryViewRef bv, const std::string& cacheKey, const std::vector<uint8_t>& data)
+{
+    bv->StoreMetadata(MetadataKey::AnalysisInfo, new BinaryNinja::Metadata(data));
+    bv->StoreMetadata(MetadataKey::AnalysisInfoCacheKey, new BinaryNinja::Metadata(cacheKey));
 }
 
 bool GlobalState::hasFlag(BinaryViewRef bv, const std::string& flag)
@@ -9,9 +9,16 @@
 
 #include "BinaryNinja.h"
 
+#include "Core/AddressRange.h"
 #include "Core/AnalysisInfo.h"
 #include "MessageHandler.h"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
 using SharedAnalysisInfo = std::shared_ptr<ObjectiveNinja::AnalysisInfo>;
 
 /**
@@ -24,6 +31,83 @@ constexpr auto DidRunStructureAnalysis = "objectiveNinja.didRunStructureAnalysis
 
 }
 
+/**
+ * Namespace to hold other metadata key constants.
+ */
+namespace MetadataKey {
+
+constexpr auto AnalysisInfo = "objectiveNinja.analysisInfo";
+constexpr auto AnalysisInfoCacheKey = "objectiveNinja.analysisInfoCacheKey";
+
+}
+
+/**
+ * Analysis info held for a view, as listed by GlobalState::analyzedViews().
+ */
+struct ViewAnalysisInfo {
+    std::string name;
+
+    /**
+     * The view's own info, followed by the info of each of its analyzed
+     * shared cache images, if any.
+     */
+    std::vector<SharedAnalysisInfo> infos;
+
+    std::shared_ptr<ObjectiveNinja::SharedCacheTables> sharedTables;
+};
+
+/**
+ * Sorted address ranges of a set of sections.
+ */
+struct SectionRanges {
+    std::vector<ObjectiveNinja::AddressRange> ranges;
+
+    bool contains(uint64_t address) const { return ObjectiveNinja::rangesContain(ranges, address); }
+};
+
+/**
+ * Immutable copy of the state held for a view, for use on hot paths.
+ *
+ * GlobalState publishes a new snapshot whenever a view's state changes, and
+ * getting the current one takes no lock. Holding on to a snapshot keeps its
+ * infos and message handler alive even if they are replaced or evicted.
+ */
+struct ViewSnapshot {
+    /**
+     * The view's own info, followed by the info of each of its analyzed
+     * shared cache images, if any. Null entries are skipped.
+     */
+    std::vector<SharedAnalysisInfo> infos;
+
+    /**
+     * Whether structure analysis results are stored for the view itself;
+     * false before the view is analyzed and after its info is evicted.
+     */
+    bool hasInfo = false;
+
+    std::shared_ptr<const MessageHandler> messageHandler;
+    bool ignored = false;
+
+    /**
+     * Set when sections were added to the view since GlobalState::
+     * takeSectionsChanged() was last called; null if sections are not
+     * watched.
+     */
+    std::shared_ptr<const std::atomic<bool>> sectionsChanged;
+
+    /**
+     * Use counter of the view, shared by all of its snapshots.
+     */
+    std::shared_ptr<std::atomic<uint64_t>> lastUse;
+
+    /**
+     * Check if the view needs structure analysis before its infos can be
+     * used, either because it was never analyzed, its info was evicted or
+     * new shared cache images were loaded.
+     */
+    bool needsAnalysis() const { return !hasInfo || (sectionsChanged && sectionsChanged->load()); }
+};
+
 /**
  * Global state/storage interface.
  */
@@ -34,15 +118,31 @@ class GlobalState {
     static BinaryViewID id(BinaryViewRef);
 
 public:
+    /**
+     * Register the hooks that free a view's state once it is closed.
+     */
+    static void registerLifecycleHooks();
+
+    /**
+     * Free all state held for a view.
+     */
+    static void forgetView(BinaryViewID);
+
     /**
      * Get the analysis info for a view.
      */
     static SharedAnalysisInfo analysisInfo(BinaryViewRef);
 
+    /**
+     * Get the current snapshot of a view's state without locking, or null if
+     * nothing has been stored for the view yet.
+     */
+    static std::shared_ptr<const ViewSnapshot> snapshot(BinaryViewRef);
+
     /**
      * Get ObjC Message Handler for a view
      */
-    static MessageHandler* messageHandler(BinaryViewRef);
+    static std::shared_ptr<const MessageHandler> messageHandler(BinaryViewRef);
     /**
      * Store analysis info for a view.
      */
@@ -53,6 +153,67 @@ public:
      */
     static bool hasAnalysisInfo(BinaryViewRef);
 
+    /**
+     * Check if the analysis info for a view was evicted by
+     * limitResidentViews() and has not been stored again since.
+     */
+    static bool wasEvicted(BinaryViewRef);
+
+    /**
+     * Evict the analysis info of the least recently used views until at most
+     * `maxViews` views have info in memory. Zero means no limit. The info of
+     * shared cache views, and info whose method lists are still deferred, is
+     * never evicted.
+     */
+    static void limitResidentViews(size_t maxViews);
+
+    /**
+     * Get the mutex that serializes structure analysis of a view. Each view
+     * has its own, so analyzing one view does not hold up others.
+     */
+    static std::shared_ptr<std::mutex> analysisMutex(BinaryViewRef);
+
+    /**
+     * Get the tables shared by the shared cache images of a view, creating
+     * them on first use.
+     */
+    static std::shared_ptr<ObjectiveNinja::SharedCacheTables> sharedCacheTables(BinaryViewRef);
+
+    /**
+     * Store analysis info for a shared cache image loaded in a view.
+     */
+    static void addImageAnalysisInfo(BinaryViewRef, SharedAnalysisInfo);
+
+    /**
+     * Get the analysis info for a view, followed by the info for each of its
+     * analyzed shared cache images, if any. Null entries are skipped.
+     */
+    static std::vector<SharedAnalysisInfo> allAnalysisInfo(BinaryViewRef);
+
+    /**
+     * Get the analysis info held for every view analyzed so far.
+     */
+    static std::vector<ViewAnalysisInfo> analyzedViews();
+
+    /**
+     * Start tracking section additions to a view, so newly loaded shared
+     * cache images can be picked up. The view is initially marked changed.
+     */
+    static void watchSections(BinaryViewRef);
+
+    /**
+     * Check if sections were added to a tracked view since the last call,
+     * clearing the mark.
+     */
+    static bool takeSectionsChanged(BinaryViewRef);
+
+    /**
+     * Get the ranges of a view's CFString sections, including those of every
+     * loaded shared cache image. Built on first use, and again after
+     * sections are added to a view whose sections are watched.
+     */
+    static std::shared_ptr<const SectionRanges> cfStringRanges(BinaryViewRef);
+
     /**
      * Add a view to the list of ignored views.
      */
@@ -63,6 +224,24 @@ public:
      */
     static bool viewIsIgnored(BinaryViewRef);
 
+    /**
+     * Get the serialized analysis info saved in a view's metadata, if it was
+     * saved under the given cache key. Returns an empty vector otherwise.
+     */
+    static std::vector<uint8_t> savedAnalysisInfo(BinaryViewRef, const std::string& cacheKey);
+
+    /**
+     * Check if analysis info was saved in a view's metadata under the given
+     * cache key.
+     */
+    static bool hasSavedAnalysisInfo(BinaryViewRef, const std::string& cacheKey);
+
+    /**
+     * Save serialized analysis info in a view's metadata, under the given
+     * cache key.
+     */
+    static void saveAnalysisInfo(BinaryViewRef, const std::string& cacheKey, const std::vector<uint8_t>&);
+
     /**
      * Check if the a metadata flag is present for a view.
      */
@@ -11,11 +11,20 @@
 #include "CustomTypes.h"
 #include "Performance.h"
 
+#include "Core/AnalysisProvider.h"
+
 #include <algorithm>
 #include <cinttypes>
+#include <future>
 
 using namespace BinaryNinja;
 
+/**
+ * Maximum number of record batches queued between analysis and application
+ * when streaming.
+ */
+constexpr size_t StreamedBatchLimit = 16;
+
 std::string InfoHandler::sanitizeText(const std::string& text)
 {
     // "Wow I AM a very@cool String@U*#(FW)E()*FUE" -> "WowIAMAVeryCoolStringU"
@@ -34,9 +43,9 @@ std::string InfoHandler::sanitizeText(const std::string& text)
     return result;
 }
 
-std::string InfoHandler::sanitizeSelector(const std::string& text)
+std::string InfoHandler::sanitizeSelector(std::string_view text)
 {
-    auto result = text;
+    auto result = std::string(text);
     std::replace(result.begin(), result.end(), ':', '_');
 
     return result;
@@ -57,10 +66,10 @@ void InfoHandler::defineVariable(BinaryViewRef bv, uint64_t address, TypeRef typ
     bv->DefineUserDataVariable(address, type);
 }
 
-void InfoHandler::defineSymbol(BinaryViewRef bv, uint64_t address, const std::string& name,
+void InfoHandler::defineSymbol(BinaryViewRef bv, uint64_t address, std::string_view name,
     const std::string& prefix, BNSymbolType symbolType)
 {
-    bv->DefineUserSymbol(new Symbol(symbolType, prefix + name, address));
+    bv->DefineUserSymbol(new Symbol(symbolType, prefix + std::string(name), address));
 }
 
 void InfoHandler::defineReference(BinaryViewRef bv, uint64_t from, uint64_t to)
@@ -93,7 +102,7 @@ void InfoHandler::applyMethodType(BinaryViewRef bv, const ObjectiveNinja::ClassI
         } else {
             type = Type::NamedType(nameOrType.name, Type::PointerType(bv->GetAddressSize(), Type::VoidType()));
             for (size_t i = nameOrType.ptrCount; i > 0; i--)
-                type = Type::PointerType(8, type);
+                type = Type::PointerType(bv->GetAddressSize(), type);
         }
 
         return type;
@@ -139,7 +148,7 @@ void InfoHandler::applyMethodType(BinaryViewRef bv, const ObjectiveNinja::ClassI
 
     std::string prefix = ci.isMetaClass ? "+" : "-";
 
-    auto name = prefix + "[" + ci.name + " " + mi.selector + "]";
+    auto name = prefix + "[" + std::string(ci.name) + " " + std::string(mi.selector) + "]";
     defineSymbol(bv, mi.implAddress, name, "", FunctionSymbol);
 }
 
@@ -156,13 +165,13 @@ QualifiedName InfoHandler::createClassType(BinaryViewRef bv, const ObjectiveNinj
         {
             type = Type::NamedType(encodedType.name, Type::PointerType(bv->GetAddressSize(), Type::VoidType()));
             for (size_t i = encodedType.ptrCount; i > 0; i--)
-                type = Type::PointerType(8, type);
+                type = Type::PointerType(bv->GetAddressSize(), type);
         }
 
         if (!type)
             type = Type::PointerType(bv->GetAddressSize(), Type::VoidType());
 
-        classTypeBuilder.AddMemberAtOffset(type, ivar.name, ivar.offset);
+        classTypeBuilder.AddMemberAtOffset(type, std::string(ivar.name), ivar.offset);
     }
 
     auto classTypeStruct = classTypeBuilder.Finalize();
@@ -171,142 +180,113 @@ QualifiedName InfoHandler::createClassType(BinaryViewRef bv, const ObjectiveNinj
     Ref<Type> classType = Type::StructureType(classTypeStruct);
     QualifiedName classQualName = bv->DefineType(classTypeId, classTypeName, classType);
 
-    std::string typeID = Type::GenerateAutoTypeId("objc", info.name);
-    bv->DefineType(typeID, info.name, Type::PointerType(bv->GetAddressSize(), Type::NamedType(bv, classTypeName)));
+    std::string className(info.name);
+    std::string typeID = Type::GenerateAutoTypeId("objc", className);
+    bv->DefineType(typeID, className, Type::PointerType(bv->GetAddressSize(), Type::NamedType(bv, classTypeName)));
 
-    return info.name;
+    return className;
 }
 
-void InfoHandler::applyInfoToView(SharedAnalysisInfo info, BinaryViewRef bv)
+InfoHandler::ViewTypes InfoHandler::viewTypes(BinaryViewRef bv)
 {
-    auto start = Performance::now();
-
-    bv->BeginUndoActions();
-
-    BinaryReader reader(bv);
-
-    auto taggedPointerType = namedType(bv, CustomTypes::TaggedPointer);
-    auto cfStringType = namedType(bv, CustomTypes::CFString);
-    auto classType = namedType(bv, CustomTypes::Class);
-    auto classDataType = namedType(bv, CustomTypes::ClassRO);
-    auto methodListType = namedType(bv, CustomTypes::MethodList);
-    auto ivarListType = namedType(bv, CustomTypes::IvarList);
-    auto ivarType = namedType(bv, CustomTypes::Ivar);
+    ViewTypes types;
+    types.taggedPointer = namedType(bv, CustomTypes::TaggedPointer);
+    types.cfString = namedType(bv, CustomTypes::CFString);
+    types.classType = namedType(bv, CustomTypes::Class);
+    types.classData = namedType(bv, CustomTypes::ClassRO);
+    types.methodList = namedType(bv, CustomTypes::MethodList);
+    types.ivarList = namedType(bv, CustomTypes::IvarList);
+    types.ivar = namedType(bv, CustomTypes::Ivar);
+
+    return types;
+}
 
-    // Create data variables and symbols for all CFString instances.
-    for (const auto& csi : info->cfStrings) {
-        reader.Seek(csi.dataAddress);
-        auto text = reader.ReadString(csi.size + 1);
-        auto sanitizedText = sanitizeText(text);
+void InfoHandler::applyCFString(BinaryViewRef bv, const ViewTypes& types, BinaryReader& reader,
+    const ObjectiveNinja::CFStringInfo& csi)
+{
+    reader.Seek(csi.dataAddress);
+    auto text = reader.ReadString(csi.size + 1);
+    auto sanitizedText = sanitizeText(text);
 
-        defineVariable(bv, csi.address, cfStringType);
-        defineVariable(bv, csi.dataAddress, stringType(csi.size));
-        defineSymbol(bv, csi.address, sanitizedText, "cf_");
-        defineSymbol(bv, csi.dataAddress, sanitizedText, "as_");
+    defineVariable(bv, csi.address, types.cfString);
+    defineVariable(bv, csi.dataAddress, stringType(csi.size));
+    defineSymbol(bv, csi.address, sanitizedText, "cf_");
+    defineSymbol(bv, csi.dataAddress, sanitizedText, "as_");
 
-        defineReference(bv, csi.address, csi.dataAddress);
-    }
+    defineReference(bv, csi.address, csi.dataAddress);
+}
 
-    // Create data variables and symbols for selectors and selector references.
-    for (const auto& sr : info->selectorRefs) {
-        auto sanitizedSelector = sanitizeSelector(sr->name);
+void InfoHandler::applySelectorRefs(BinaryViewRef bv, const ViewTypes& types,
+    const ObjectiveNinja::SelectorTable& selectorRefs)
+{
+    for (const auto sr : selectorRefs) {
+        auto sanitizedSelector = sanitizeSelector(sr.name);
 
-        defineVariable(bv, sr->address, taggedPointerType);
-        defineVariable(bv, sr->nameAddress, stringType(sr->name.size()));
-        defineSymbol(bv, sr->address, sanitizedSelector, "sr_");
-        defineSymbol(bv, sr->nameAddress, sanitizedSelector, "sl_");
+        defineVariable(bv, sr.address, types.taggedPointer);
+        defineVariable(bv, sr.nameAddress, stringType(sr.name.size()));
+        defineSymbol(bv, sr.address, sanitizedSelector, "sr_");
+        defineSymbol(bv, sr.nameAddress, sanitizedSelector, "sl_");
 
-        defineReference(bv, sr->address, sr->nameAddress);
+        defineReference(bv, sr.address, sr.nameAddress);
     }
+}
 
-    unsigned totalMethods = 0;
-
-    std::map<uint64_t, std::string> addressToClassMap;
-
-    // Create data variables and symbols for the analyzed classes.
-    for (const auto& ci : info->classes) {
-        defineVariable(bv, ci.listPointer, taggedPointerType);
-        defineVariable(bv, ci.address, classType);
-        defineVariable(bv, ci.dataAddress, classDataType);
-        defineVariable(bv, ci.nameAddress, stringType(ci.name.size()));
-        defineSymbol(bv, ci.listPointer, ci.name, "cp_");
-        defineSymbol(bv, ci.address, ci.name, "cl_");
-        addressToClassMap[ci.address] = ci.name;
-        defineSymbol(bv, ci.dataAddress, ci.name, "ro_");
-        defineSymbol(bv, ci.nameAddress, ci.name, "nm_");
-
-        defineReference(bv, ci.listPointer, ci.address);
-        defineReference(bv, ci.address, ci.dataAddress);
-        defineReference(bv, ci.dataAddress, ci.nameAddress);
-        defineReference(bv, ci.dataAddress, ci.methodListAddress);
-
-        auto methodSelfType = createClassType(bv, ci, ci.ivarList);
-
-        if (ci.methodList.address == 0 || ci.methodList.methods.empty())
-            continue;
-
-        auto methodType = ci.methodList.hasRelativeOffsets()
-            ? bv->GetTypeByName(CustomTypes::MethodListEntry)
-            : bv->GetTypeByName(CustomTypes::Method);
-
-        // Create data variables for each method in the method list.
-        for (const auto& mi : ci.methodList.methods) {
-            ++totalMethods;
-
-            defineVariable(bv, mi.address, methodType);
-            defineSymbol(bv, mi.address, sanitizeSelector(mi.selector), "mt_");
-            defineVariable(bv, mi.typeAddress, stringType(mi.type.size()));
-
-            defineReference(bv, ci.methodList.address, mi.address);
-            defineReference(bv, mi.address, mi.nameAddress);
-            defineReference(bv, mi.address, mi.typeAddress);
-            defineReference(bv, mi.address, mi.implAddress);
-
-            applyMethodType(bv, ci, methodSelfType, mi);
+void InfoHandler::applyClass(BinaryViewRef bv, const ViewTypes& types, const ObjectiveNinja::ClassInfo& ci)
+{
+    defineVariable(bv, ci.listPointer, types.taggedPointer);
+    defineVariable(bv, ci.address, types.classType);
+    defineVariable(bv, ci.dataAddress, types.classData);
+    defineVariable(bv, ci.nameAddress, stringType(ci.name.size()));
+    defineSymbol(bv, ci.listPointer, ci.name, "cp_");
+    defineSymbol(bv, ci.address, ci.name, "cl_");
+    defineSymbol(bv, ci.dataAddress, ci.name, "ro_");
+    defineSymbol(bv, ci.nameAddress, ci.name, "nm_");
+
+    defineReference(bv, ci.listPointer, ci.address);
+    defineReference(bv, ci.address, ci.dataAddress);
+    defineReference(bv, ci.dataAddress, ci.nameAddress);
+    defineReference(bv, ci.dataAddress, ci.methodListAddress);
+
+    createClassType(bv, ci, ci.ivarList ? *ci.ivarList : ObjectiveNinja::IvarListInfo {});
+
+    if (ci.ivarList) {
+        defineVariable(bv, ci.ivarListAddress, types.ivarList);
+        defineSymbol(bv, ci.ivarListAddress, ci.name, "vl_");
+
+        for (const auto& ii : ci.ivarList->ivars) {
+            defineVariable(bv, ii.address, types.ivar);
+            defineSymbol(bv, ii.address, ii.name, "iv_");
         }
+    }
+}
 
-        if (ci.ivarListAddress != 0) {
-            defineVariable(bv, ci.ivarListAddress, ivarListType);
-            defineSymbol(bv, ci.ivarListAddress, ci.name, "vl_");
-
-            for (const auto& ii : ci.ivarList.ivars) {
-                defineVariable(bv, ii.address, ivarType);
-                defineSymbol(bv, ii.address, ii.name, "iv_");
-            }
-        }
-        if (ci.metaClassInfo) {
-            for (const auto& mi : ci.metaClassInfo->info.methodList.methods) {
-                ++totalMethods;
-
-                defineVariable(bv, mi.address, methodType);
-                defineSymbol(bv, mi.address, sanitizeSelector(mi.selector), "mt_");
-                defineVariable(bv, mi.typeAddress, stringType(mi.type.size()));
-
-                defineReference(bv, ci.metaClassInfo->info.methodList.address, mi.address);
-                defineReference(bv, mi.address, mi.nameAddress);
-                defineReference(bv, mi.address, mi.typeAddress);
-                defineReference(bv, mi.address, mi.implAddress);
-                applyMethodType(bv, ci.metaClassInfo->info, methodSelfType, mi);
-            }
-        }
+std::optional<std::string_view> InfoHandler::sharedClassName(const SharedAnalysisInfo& info, uint64_t address)
+{
+    if (!info->sharedTables)
+        return std::nullopt;
 
-        // Create a data variable and symbol for the method list header.
-        defineVariable(bv, ci.methodListAddress, methodListType);
-        defineSymbol(bv, ci.methodListAddress, ci.name, "ml_");
-    }
+    return info->sharedTables->className(address);
+}
 
+void InfoHandler::applyClassRefs(BinaryViewRef bv, const ViewTypes& types, SharedAnalysisInfo info,
+    const std::map<uint64_t, std::string_view>& addressToClassMap)
+{
     for (const auto classRef : info->classRefs) {
-        bv->DefineDataVariable(classRef.address, taggedPointerType);
+        bv->DefineDataVariable(classRef.address, types.taggedPointer);
 
         if (classRef.referencedAddress != 0) {
             auto localClass = addressToClassMap.find(classRef.referencedAddress);
             if (localClass != addressToClassMap.end())
                 defineSymbol(bv, classRef.address, localClass->second, "cr_");
+            else if (!classRef.importedName.empty())
+                defineSymbol(bv, classRef.address, classRef.importedName, "cr_");
+            else if (auto sharedClass = sharedClassName(info, classRef.referencedAddress))
+                defineSymbol(bv, classRef.address, *sharedClass, "cr_");
         }
     }
 
     for (const auto superRef : info->superRefs) {
-        bv->DefineDataVariable(superRef.address, taggedPointerType);
+        bv->DefineDataVariable(superRef.address, types.taggedPointer);
 
         if (superRef.referencedAddress == 0)
             continue;
@@ -314,21 +294,71 @@ void InfoHandler::applyInfoToView(SharedAnalysisInfo info, BinaryViewRef bv)
         auto localClass = addressToClassMap.find(superRef.referencedAddress);
         if (localClass != addressToClassMap.end())
             defineSymbol(bv, superRef.address, localClass->second, "su_");
+        else if (!superRef.importedName.empty())
+            defineSymbol(bv, superRef.address, superRef.importedName, "su_");
+        else if (auto sharedClass = sharedClassName(info, superRef.referencedAddress))
+            defineSymbol(bv, superRef.address, *sharedClass, "su_");
     }
+}
 
+void InfoHandler::applyIvarSection(BinaryViewRef bv)
+{
     if (auto ivarSection = bv->GetSectionByName("__objc_ivar")) {
         uint64_t addr = ivarSection->GetStart();
         uint64_t end = addr + ivarSection->GetLength();
 
-        auto ivarSectionEntryTypeBuilder = new TypeBuilder(Type::IntegerType(8, false));
+        auto ivarSectionEntryTypeBuilder = new TypeBuilder(Type::IntegerType(bv->GetAddressSize(), false));
         ivarSectionEntryTypeBuilder->SetConst(true);
         auto ivarSectionEntryType = ivarSectionEntryTypeBuilder->Finalize();
 
         while (addr < end) {
             defineVariable(bv, addr, ivarSectionEntryType);
-            addr += 8;
+            addr += bv->GetAddressSize();
         }
     }
+}
+
+void InfoHandler::logTotals(SharedAnalysisInfo info, size_t totalClasses, size_t totalMethods, size_t totalCFStrings)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    log->LogInfo("Found %d classes, %d methods, %d selector references",
+        totalClasses, totalMethods, info->selectorRefs.size());
+    log->LogInfo("Found %d CFString instances", totalCFStrings);
+    log->LogInfo("Found %d class references, %d superclass references", info->classRefs.size(), info->superRefs.size());
+}
+
+void InfoHandler::applyInfoToView(SharedAnalysisInfo info, BinaryViewRef bv)
+{
+    auto start = Performance::now();
+
+    bv->BeginUndoActions();
+
+    BinaryReader reader(bv);
+    const auto types = viewTypes(bv);
+
+    // Create data variables and symbols for all CFString instances.
+    for (const auto& csi : info->cfStrings)
+        applyCFString(bv, types, reader, csi);
+
+    // Create data variables and symbols for selectors and selector references.
+    applySelectorRefs(bv, types, info->selectorRefs);
+
+    std::map<uint64_t, std::string_view> addressToClassMap;
+
+    // Create data variables and symbols for the analyzed classes.
+    for (const auto& ci : info->classes) {
+        applyClass(bv, types, ci);
+        addressToClassMap[ci.address] = ci.name;
+    }
+
+    // Method lists may have been deferred, in which case method info is
+    // applied by applyMethodInfoToView() once they are resolved.
+    unsigned totalMethods = 0;
+    if (!info->hasDeferredMethods())
+        totalMethods = applyMethodInfo(info, bv);
+
+    applyClassRefs(bv, types, info, addressToClassMap);
+    applyIvarSection(bv);
 
     bv->CommitUndoActions();
     bv->UpdateAnalysis();
@@ -337,8 +367,202 @@ void InfoHandler::applyInfoToView(SharedAnalysisInfo info, BinaryViewRef bv)
 
     const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
     log->LogInfo("Analysis results applied in %lu ms", elapsed.count());
-    log->LogInfo("Found %d classes, %d methods, %d selector references",
-        info->classes.size(), totalMethods, info->selectorRefs.size());
-    log->LogInfo("Found %d CFString instances", info->cfStrings.size());
-    log->LogInfo("Found %d class references, %d superclass references", info->classRefs.size(), info->superRefs.size());
+    logTotals(info, info->classes.size(), totalMethods, info->cfStrings.size());
+}
+
+SharedAnalysisInfo InfoHandler::analyzeAndApply(ObjectiveNinja::SharedAbstractFile file,
+    const ObjectiveNinja::AnalysisOptions& options, BinaryViewRef bv, bool keepRecords,
+    const std::function<void(size_t)>& onProgress, const std::function<bool()>& isCancelled)
+{
+    auto start = Performance::now();
+
+    // Analysis runs in the background, while records are applied to the view
+    // on this thread as they arrive. The queue bounds how far analysis can get
+    // ahead, and with it how many records are held in memory at once.
+    ObjectiveNinja::RecordQueue records(StreamedBatchLimit);
+    auto analysis = std::async(std::launch::async, [&] {
+        try {
+            auto info = ObjectiveNinja::AnalysisProvider::infoForFile(file, options, &records);
+            records.close();
+            return info;
+        } catch (...) {
+            records.close();
+            throw;
+        }
+    });
+
+    bv->BeginUndoActions();
+
+    BinaryReader reader(bv);
+    const auto types = viewTypes(bv);
+    auto methodListType = types.methodList;
+
+    // Only the address and name of each class are kept, for resolving class
+    // references once analysis is done.
+    std::map<uint64_t, std::string_view> addressToClassMap;
+    size_t totalClasses = 0;
+    size_t totalMethods = 0;
+    size_t totalCFStrings = 0;
+
+    // Classes are stored in the info anyway when method lists are deferred.
+    const bool keepClasses = keepRecords && !options.lazyMethodLists;
+    std::vector<ObjectiveNinja::ClassInfo> keptClasses;
+    std::vector<ObjectiveNinja::CFStringInfo> keptCFStrings;
+
+    SharedAnalysisInfo info;
+    try {
+        while (auto batch = records.pop()) {
+            for (auto& record : *batch) {
+                if (auto* csi = std::get_if<ObjectiveNinja::CFStringInfo>(&record)) {
+                    applyCFString(bv, types, reader, *csi);
+                    ++totalCFStrings;
+
+                    if (keepRecords)
+                        keptCFStrings.push_back(*csi);
+                } else if (auto* ci = std::get_if<ObjectiveNinja::ClassInfo>(&record)) {
+                    applyClass(bv, types, *ci);
+                    totalMethods += applyClassMethods(bv, methodListType, *ci);
+                    addressToClassMap[ci->address] = ci->name;
+                    ++totalClasses;
+
+                    if (keepClasses)
+                        keptClasses.push_back(std::move(*ci));
+                }
+            }
+
+            if (onProgress)
+                onProgress(totalClasses);
+
+            // Closing the queue (below) makes the analyzers stop at their
+            // next batch.
+            if (isCancelled && isCancelled())
+                throw ObjectiveNinja::AnalysisCancelled();
+        }
+
+        info = analysis.get();
+
+        if (keepClasses)
+            info->classes = std::move(keptClasses);
+        if (keepRecords)
+            info->cfStrings = std::move(keptCFStrings);
+    } catch (...) {
+        // Unblock and wait for the analysis thread, which references the
+        // queue, before leaving.
+        records.close();
+        if (analysis.valid())
+            analysis.wait();
+
+        bv->CommitUndoActions();
+        throw;
+    }
+
+    applySelectorRefs(bv, types, info->selectorRefs);
+    applyClassRefs(bv, types, info, addressToClassMap);
+    applyIvarSection(bv);
+
+    bv->CommitUndoActions();
+    bv->UpdateAnalysis();
+
+    auto elapsed = Performance::elapsed<std::chrono::milliseconds>(start);
+
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    log->LogInfo("Structures analyzed and applied in %lu ms", elapsed.count());
+    logTotals(info, totalClasses, totalMethods, totalCFStrings);
+
+    return info;
+}
+
+std::vector<SharedAnalysisInfo> InfoHandler::analyzeAndApplyImages(
+    const std::vector<ObjectiveNinja::SharedAbstractFile>& images,
+    std::shared_ptr<ObjectiveNinja::SharedCacheTables> tables, const ObjectiveNinja::AnalysisOptions& options,
+    BinaryViewRef bv, std::vector<std::exception_ptr>* errors)
+{
+    auto start = Performance::now();
+
+    // Classes are only added to the shared table once every image is done,
+    // so all references between the new images can be named when applied.
+    auto infos = ObjectiveNinja::AnalysisProvider::infoForImages(images, tables, options, errors);
+    for (const auto& info : infos)
+        if (info)
+            applyInfoToView(info, bv);
+
+    auto elapsed = Performance::elapsed<std::chrono::milliseconds>(start);
+
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    log->LogInfo("%zu shared cache image(s) analyzed and applied in %lu ms; %zu classes known",
+        images.size(), elapsed.count(), tables->classCount());
+
+    return infos;
+}
+
+unsigned InfoHandler::applyMethodList(BinaryViewRef bv, const ObjectiveNinja::ClassInfo& ci,
+    const QualifiedName& classTypeName, const ObjectiveNinja::MethodListInfo& mli)
+{
+    auto methodType = mli.hasRelativeOffsets()
+        ? bv->GetTypeByName(CustomTypes::MethodListEntry)
+        : bv->GetTypeByName(CustomTypes::Method);
+
+    // Create data variables for each method in the method list.
+    for (const auto& mi : mli.methods) {
+        defineVariable(bv, mi.address, methodType);
+        defineSymbol(bv, mi.address, sanitizeSelector(mi.selector), "mt_");
+        defineVariable(bv, mi.typeAddress, stringType(mi.type.size()));
+
+        defineReference(bv, mli.address, mi.address);
+        defineReference(bv, mi.address, mi.nameAddress);
+        defineReference(bv, mi.address, mi.typeAddress);
+        defineReference(bv, mi.address, mi.implAddress);
+
+        applyMethodType(bv, ci, classTypeName, mi);
+    }
+
+    return static_cast<unsigned>(mli.methods.size());
+}
+
+unsigned InfoHandler::applyClassMethods(BinaryViewRef bv, TypeRef methodListType, const ObjectiveNinja::ClassInfo& ci)
+{
+    // Matches the name of the type created by createClassType().
+    QualifiedName methodSelfType = std::string(ci.name);
+
+    unsigned totalMethods = 0;
+    if (ci.methodList && !ci.methodList->methods.empty()) {
+        totalMethods += applyMethodList(bv, ci, methodSelfType, *ci.methodList);
+
+        // Create a data variable and symbol for the method list header.
+        defineVariable(bv, ci.methodListAddress, methodListType);
+        defineSymbol(bv, ci.methodListAddress, ci.name, "ml_");
+    }
+
+    // A class may have class methods without having any instance methods.
+    if (ci.metaClassInfo && ci.metaClassInfo->info.methodList)
+        totalMethods += applyMethodList(bv, ci.metaClassInfo->info, methodSelfType, *ci.metaClassInfo->info.methodList);
+
+    return totalMethods;
+}
+
+unsigned InfoHandler::applyMethodInfo(SharedAnalysisInfo info, BinaryViewRef bv)
+{
+    auto methodListType = namedType(bv, CustomTypes::MethodList);
+
+    unsigned totalMethods = 0;
+    for (const auto& ci : info->classes)
+        totalMethods += applyClassMethods(bv, methodListType, ci);
+
+    return totalMethods;
+}
+
+void InfoHandler::applyMethodInfoToView(SharedAnalysisInfo info, BinaryViewRef bv)
+{
+    auto start = Performance::now();
+
+    bv->BeginUndoActions();
+    auto totalMethods = applyMethodInfo(info, bv);
+    bv->CommitUndoActions();
+    bv->UpdateAnalysis();
+
+    auto elapsed = Performance::elapsed<std::chrono::milliseconds>(start);
+
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    log->LogInfo("Deferred method info applied in %lu ms", elapsed.count());
+    log->LogInfo("Found %d methods", totalMethods);
 }
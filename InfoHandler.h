@@ -7,10 +7,18 @@
 
 #pragma once
 
+#include "Core/AbstractFile.h"
 #include "Core/AnalysisInfo.h"
+#include "Core/Analyzer.h"
 
 #include "BinaryNinja.h"
 
+#include <exception>
+#include <functional>
+#include <map>
+#include <optional>
+#include <vector>
+
 using SharedAnalysisInfo = std::shared_ptr<ObjectiveNinja::AnalysisInfo>;
 
 /**
@@ -31,7 +39,7 @@ class InfoHandler {
      * Sanitize a selector so that it round-trips the type parser. Colon
      * characters will be replaced underscores.
      */
-    static std::string sanitizeSelector(const std::string&);
+    static std::string sanitizeSelector(std::string_view);
 
     /**
      * Get the type with the given name defined inside the BinaryView.
@@ -52,7 +60,7 @@ class InfoHandler {
      * Shorthand function for defining a user symbol, with an optional prefix.
      */
     static inline void defineSymbol(BinaryViewRef, uint64_t,
-        const std::string& name, const std::string& prefix = "",
+        std::string_view name, const std::string& prefix = "",
         BNSymbolType type = DataSymbol);
 
     /**
@@ -69,9 +77,111 @@ class InfoHandler {
     static BinaryNinja::QualifiedName createClassType(BinaryViewRef,
         const ObjectiveNinja::ClassInfo&, const ObjectiveNinja::IvarListInfo&);
 
+    /**
+     * Types defined by CustomTypes, looked up once per application.
+     */
+    struct ViewTypes {
+        TypeRef taggedPointer;
+        TypeRef cfString;
+        TypeRef classType;
+        TypeRef classData;
+        TypeRef methodList;
+        TypeRef ivarList;
+        TypeRef ivar;
+    };
+
+    static ViewTypes viewTypes(BinaryViewRef);
+
+    static void applyCFString(BinaryViewRef, const ViewTypes&, BinaryNinja::BinaryReader&,
+        const ObjectiveNinja::CFStringInfo&);
+
+    static void applySelectorRefs(BinaryViewRef, const ViewTypes&, const ObjectiveNinja::SelectorTable&);
+
+    /**
+     * Create data variables, symbols and types for a class and its ivars,
+     * but not its methods.
+     */
+    static void applyClass(BinaryViewRef, const ViewTypes&, const ObjectiveNinja::ClassInfo&);
+
+    /**
+     * Get the name of a class defined by another image of the same shared
+     * cache, if the info belongs to one.
+     */
+    static std::optional<std::string_view> sharedClassName(const SharedAnalysisInfo&, uint64_t address);
+
+    /**
+     * Create data variables and symbols for class and superclass references,
+     * naming local classes through the given map, and classes from other
+     * shared cache images through the shared class table.
+     */
+    static void applyClassRefs(BinaryViewRef, const ViewTypes&, SharedAnalysisInfo,
+        const std::map<uint64_t, std::string_view>& addressToClassMap);
+
+    static void applyIvarSection(BinaryViewRef);
+
+    static void logTotals(SharedAnalysisInfo, size_t totalClasses, size_t totalMethods, size_t totalCFStrings);
+
+    /**
+     * Create data variables, symbols and types for the methods in a method
+     * list. Returns the number of methods.
+     */
+    static unsigned applyMethodList(BinaryViewRef, const ObjectiveNinja::ClassInfo&,
+        const BinaryNinja::QualifiedName& classTypeName, const ObjectiveNinja::MethodListInfo&);
+
+    /**
+     * Apply the method lists of a class and its metaclass. Returns the number
+     * of methods.
+     */
+    static unsigned applyClassMethods(BinaryViewRef, TypeRef methodListType, const ObjectiveNinja::ClassInfo&);
+
+    /**
+     * Apply the method lists of all classes. Returns the number of methods.
+     */
+    static unsigned applyMethodInfo(SharedAnalysisInfo, BinaryViewRef);
+
 public:
     /**
-     * Apply AnalysisInfo to a BinaryView.
+     * Apply AnalysisInfo to a BinaryView. If the info's method lists have
+     * been deferred, method info is left out.
      */
     static void applyInfoToView(SharedAnalysisInfo, BinaryViewRef);
+
+    /**
+     * Analyze a file and apply the results to a BinaryView as they are
+     * produced, rather than once analysis is complete. Classes and CFStrings
+     * are not kept; the returned info only holds the selector references,
+     * class references and method implementations needed afterwards (plus
+     * classes, if method lists are deferred).
+     *
+     * If `keepRecords` is true, classes and CFStrings are moved into the
+     * returned info once applied, so that it is complete (e.g. for caching).
+     * They should be freed with AnalysisInfo::releaseRecords() once they are
+     * no longer needed.
+     *
+     * If given, `onProgress` is called with the number of classes applied so
+     * far after each batch of records, and `isCancelled` is polled between
+     * batches. Once it returns true, analysis is stopped and
+     * ObjectiveNinja::AnalysisCancelled is thrown; whatever was applied until
+     * then is left in the view.
+     */
+    static SharedAnalysisInfo analyzeAndApply(ObjectiveNinja::SharedAbstractFile,
+        const ObjectiveNinja::AnalysisOptions&, BinaryViewRef, bool keepRecords = false,
+        const std::function<void(size_t)>& onProgress = {}, const std::function<bool()>& isCancelled = {});
+
+    /**
+     * Analyze several shared cache images concurrently, sharing the given
+     * tables between them, and apply the results to a BinaryView. Returns the
+     * info of each image, in order; images whose analysis failed get a null
+     * info and are not applied. If given, `errors` receives the cause of each
+     * failure; see AnalysisProvider::infoForImages().
+     */
+    static std::vector<SharedAnalysisInfo> analyzeAndApplyImages(
+        const std::vector<ObjectiveNinja::SharedAbstractFile>&, std::shared_ptr<ObjectiveNinja::SharedCacheTables>,
+        const ObjectiveNinja::AnalysisOptions&, BinaryViewRef, std::vector<std::exception_ptr>* errors = nullptr);
+
+    /**
+     * Apply method info to a BinaryView, after deferred method lists have
+     * been resolved.
+     */
+    static void applyMethodInfoToView(SharedAnalysisInfo, BinaryViewRef);
 };
@@ -57,7 +57,7 @@ std::set<uint64_t> MessageHandler::findMsgSendFunctions(BinaryNinja::Ref<BinaryN
     return results;
 }
 
-bool MessageHandler::isMessageSend(uint64_t functionAddress)
+bool MessageHandler::isMessageSend(uint64_t functionAddress) const
 {
     return m_msgSendFunctions.count(functionAddress);
 }
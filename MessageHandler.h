@@ -12,5 +12,5 @@ public:
 
     std::set<uint64_t> getMessageSendFunctions() const { return m_msgSendFunctions; }
     bool hasMessageSendFunctions() const { return m_msgSendFunctions.size() != 0; }
-    bool isMessageSend(uint64_t);
+    bool isMessageSend(uint64_t) const;
 };
@@ -8,6 +8,8 @@
 #include "Commands.h"
 #include "Constants.h"
 #include "DataRenderers.h"
+#include "GlobalState.h"
+#include "PluginSettings.h"
 #include "Workflow.h"
 #include "ArchitectureHooks.h"
 
@@ -21,12 +23,16 @@ BINARYNINJAPLUGIN bool CorePluginInit()
     FastPointerDataRenderer::Register();
     RelativePointerDataRenderer::Register();
 
+    PluginSettings::registerSettings();
+    GlobalState::registerLifecycleHooks();
     Workflow::registerActivities();
     Commands::registerCommands();
 
     std::vector<BinaryNinja::Ref<BinaryNinja::Architecture>> targets = {
         BinaryNinja::Architecture::GetByName("aarch64"),
-        BinaryNinja::Architecture::GetByName("x86_64")
+        BinaryNinja::Architecture::GetByName("x86_64"),
+        BinaryNinja::Architecture::GetByName("armv7"),
+        BinaryNinja::Architecture::GetByName("thumb2")
     };
     for (auto& target : targets) {
         if (target)
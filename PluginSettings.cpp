@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#include "PluginSettings.h"
+
+#include "Constants.h"
+
+void PluginSettings::registerSettings()
+{
+    auto settings = BinaryNinja::Settings::Instance();
+    settings->RegisterGroup(SettingsGroupName, "Objective-C");
+
+    settings->RegisterSetting(AnalysisWorkerCountSetting,
+        R"({
+            "title" : "Structure Analysis Threads",
+            "type" : "number",
+            "default" : 0,
+            "minValue" : 0,
+            "maxValue" : 256,
+            "description" : "Number of threads used to analyze Objective-C structures. Set to 0 to use one thread per CPU core.",
+            "ignore" : ["SettingsProjectScope"]
+        })");
+
+    settings->RegisterSetting(LazyMethodListsSetting,
+        R"({
+            "title" : "Lazy Method Lists",
+            "type" : "boolean",
+            "default" : false,
+            "description" : "Only index classes and selectors before analyzing functions, and parse method lists the first time a message send is resolved. Reduces the delay before the first functions are analyzed on very large binaries.",
+            "ignore" : ["SettingsProjectScope"]
+        })");
+
+    settings->RegisterSetting(StoreAnalysisInViewSetting,
+        R"({
+            "title" : "Store Structure Analysis in Database",
+            "type" : "boolean",
+            "default" : false,
+            "description" : "Save the results of Objective-C structure analysis in the view's metadata, so that reopening a database skips structure analysis. Classes and CFStrings are then held in memory until they are saved, and the Objective-C sections are hashed on every open.",
+            "ignore" : ["SettingsProjectScope"]
+        })");
+
+    settings->RegisterSetting(AnalysisCacheDirectorySetting,
+        R"({
+            "title" : "Structure Analysis Cache Directory",
+            "type" : "string",
+            "default" : "",
+            "description" : "Directory in which to cache the results of Objective-C structure analysis, keyed by image UUID and contents. Reopening a cached binary skips structure analysis. Leave empty to disable the cache.",
+            "ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+        })");
+
+    settings->RegisterSetting(MaxResidentViewsSetting,
+        R"({
+            "title" : "Maximum Resident Views",
+            "type" : "number",
+            "default" : 0,
+            "minValue" : 0,
+            "maxValue" : 1024,
+            "description" : "Number of views to keep Objective-C structure analysis results in memory for. Results of the least recently used views beyond this are freed, and loaded again from the cache or re-analyzed when needed. Set to 0 for no limit.",
+            "ignore" : ["SettingsProjectScope", "SettingsResourceScope"]
+        })");
+
+    settings->RegisterSetting(BackgroundAnalysisSetting,
+        R"({
+            "title" : "Background Structure Analysis",
+            "type" : "boolean",
+            "default" : true,
+            "description" : "Start analyzing Objective-C structures as soon as a view is opened, alongside initial function analysis. Functions only wait for it when they contain message sends or CFString references. When disabled, structure analysis runs when the first function is analyzed.",
+            "ignore" : ["SettingsProjectScope"]
+        })");
+}
+
+ObjectiveNinja::AnalysisOptions PluginSettings::analysisOptions(BinaryViewRef bv)
+{
+    auto settings = BinaryNinja::Settings::Instance();
+
+    ObjectiveNinja::AnalysisOptions options;
+    options.workerCount = static_cast<unsigned>(settings->Get<uint64_t>(AnalysisWorkerCountSetting, bv));
+    options.lazyMethodLists = settings->Get<bool>(LazyMethodListsSetting, bv);
+
+    return options;
+}
+
+bool PluginSettings::storeAnalysisInView(BinaryViewRef bv)
+{
+    return BinaryNinja::Settings::Instance()->Get<bool>(StoreAnalysisInViewSetting, bv);
+}
+
+std::string PluginSettings::analysisCacheDirectory(BinaryViewRef bv)
+{
+    return BinaryNinja::Settings::Instance()->Get<std::string>(AnalysisCacheDirectorySetting, bv);
+}
+
+size_t PluginSettings::maxResidentViews()
+{
+    return static_cast<size_t>(BinaryNinja::Settings::Instance()->Get<uint64_t>(MaxResidentViewsSetting));
+}
+
+bool PluginSettings::backgroundAnalysis(BinaryViewRef bv)
+{
+    return BinaryNinja::Settings::Instance()->Get<bool>(BackgroundAnalysisSetting, bv);
+}
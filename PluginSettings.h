@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022-2023 Jon Palmisciano. All rights reserved.
+ *
+ * Use of this source code is governed by the BSD 3-Clause license; the full
+ * terms of the license can be found in the LICENSE.txt file.
+ */
+
+#pragma once
+
+#include "BinaryNinja.h"
+
+#include "Core/Analyzer.h"
+
+/**
+ * User-configurable plugin settings.
+ */
+class PluginSettings {
+public:
+    /**
+     * Register the plugin's settings with Binary Ninja.
+     */
+    static void registerSettings();
+
+    /**
+     * Get the structure analysis options configured for a view.
+     */
+    static ObjectiveNinja::AnalysisOptions analysisOptions(BinaryViewRef);
+
+    /**
+     * Check if structure analysis results should be saved in a view's
+     * metadata.
+     */
+    static bool storeAnalysisInView(BinaryViewRef);
+
+    /**
+     * Get the directory to cache structure analysis results in, or an empty
+     * string if the cache is disabled.
+     */
+    static std::string analysisCacheDirectory(BinaryViewRef);
+
+    /**
+     * Get the maximum number of views to keep structure analysis results in
+     * memory for, or zero if there is no limit.
+     */
+    static size_t maxResidentViews();
+
+    /**
+     * Check if structure analysis should start in the background as soon as
+     * a view is opened.
+     */
+    static bool backgroundAnalysis(BinaryViewRef);
+};
@@ -11,22 +11,46 @@
 #include "CustomTypes.h"
 #include "GlobalState.h"
 #include "InfoHandler.h"
-#include "Performance.h"
+#include "PluginSettings.h"
 #include "ArchitectureHooks.h"
 
 #include "Core/AnalysisProvider.h"
 #include "Core/BinaryViewFile.h"
+#include "Core/InfoSerializer.h"
 
 #include <lowlevelilinstruction.h>
 
+#include <cinttypes>
+#include <cstdio>
+#include <exception>
+#include <optional>
 #include <queue>
 
-static std::mutex g_initialAnalysisMutex;
-
 using SectionRef = BinaryNinja::Ref<BinaryNinja::Section>;
 using SymbolRef = BinaryNinja::Ref<BinaryNinja::Symbol>;
 
-void Workflow::rewriteMethodCall(LLILFunctionRef ssa, size_t insnIndex)
+/**
+ * Get a description of an exception for logging.
+ */
+static std::string describeError(const std::exception_ptr& error)
+{
+    if (!error)
+        return "unknown error";
+
+    try {
+        std::rethrow_exception(error);
+    } catch (const ObjectiveNinja::ReadError& e) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s at 0x%" PRIx64, e.what(), e.offset);
+        return buffer;
+    } catch (const std::exception& e) {
+        return e.what();
+    } catch (...) {
+        return "unknown error";
+    }
+}
+
+void Workflow::rewriteMethodCall(LLILFunctionRef ssa, size_t insnIndex, const std::vector<SharedAnalysisInfo>& infos)
 {
     const auto bv = ssa->GetFunction()->GetView();
     const auto llil = ssa->GetNonSSAForm();
@@ -44,17 +68,59 @@ void Workflow::rewriteMethodCall(LLILFunctionRef ssa, size_t insnIndex)
     // example, if the selector is for a method defined outside the current
     // binary. If this is the case, there are no meaningful changes that can be
     // made to the IL, and the operation should be aborted.
-    const auto info = GlobalState::analysisInfo(bv);
-    if (!info || !info->selectorRefsByKey.count(rawSelector))
+    //
+    // Shared cache views have one info per analyzed image; the selector
+    // reference belongs to whichever image the call site is in.
+    std::optional<ObjectiveNinja::SelectorRefInfo> selectorRef;
+    SharedAnalysisInfo owner;
+    for (const auto& info : infos) {
+        selectorRef = info->selectorRefs.findByRawSelector(rawSelector);
+        if (!selectorRef)
+            selectorRef = info->selectorRefs.findByAddress(rawSelector);
+        if (selectorRef) {
+            owner = info;
+            break;
+        }
+    }
+    if (!selectorRef)
         return;
-    const auto selectorRef = info->selectorRefsByKey[rawSelector];
+
+    // If method lists were deferred, the first call site to get here parses
+    // them; all others wait for it to finish. Only the image owning the
+    // selector reference is resolved, so that the first call site does not
+    // pay for every image of a shared cache; other images are resolved once
+    // one of their own call sites is reached.
+    try {
+        const auto openFile = [&] {
+            return std::make_shared<ObjectiveNinja::BinaryViewFile>(bv, true, owner->imageName);
+        };
+
+        if (owner->resolveMethods(openFile))
+            finishResolvedMethods(bv, owner);
+    } catch (...) {
+        const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+        log->LogError("Method list analysis failed; binary may be malformed.");
+    }
 
     // Attempt to look up the implementation for the given selector, first by
     // using the raw selector, then by the address of the selector reference. If
-    // the lookup fails in both cases, abort.
-    uint64_t implAddress = info->methodImpls[selectorRef->rawSelector];
-    if (!implAddress)
-        implAddress = info->methodImpls[selectorRef->address];
+    // the lookup fails in both cases, abort. Selector strings are shared
+    // between shared cache images, so the implementation may come from any
+    // image whose methods are resolved, starting with the owning one.
+    const auto findImpl = [&](const SharedAnalysisInfo& info) -> uint64_t {
+        if (info->hasDeferredMethods())
+            return 0;
+
+        auto address = info->dispatchIndex.find(selectorRef->rawSelector);
+        if (!address)
+            address = info->dispatchIndex.find(selectorRef->address);
+        return address;
+    };
+
+    uint64_t implAddress = findImpl(owner);
+    for (size_t i = 0; i < infos.size() && !implAddress; ++i)
+        if (infos[i] != owner)
+            implAddress = findImpl(infos[i]);
     if (!implAddress)
         return;
 
@@ -71,6 +137,25 @@ void Workflow::rewriteMethodCall(LLILFunctionRef ssa, size_t insnIndex)
     llil->GenerateSSAForm();
 }
 
+void Workflow::finishResolvedMethods(BinaryViewRef bv, SharedAnalysisInfo info)
+{
+    // Only the dispatch index is needed to rewrite calls, so the rest is left
+    // to a worker rather than holding up the call site that resolved them.
+    BinaryNinja::WorkerEnqueue([bv, info] {
+        InfoHandler::applyMethodInfoToView(info, bv);
+
+        // Only the view's own info is cached, not that of shared cache
+        // images.
+        if (info == GlobalState::analysisInfo(bv) && shouldCacheInfo(bv)) {
+            ObjectiveNinja::BinaryViewFile file(bv, false);
+            cacheInfo(bv, ObjectiveNinja::CacheKey::forFile(file), *info);
+        }
+
+        // Classes were only kept for resolving and applying their methods.
+        info->releaseRecords();
+    }, "Objective-C method info");
+}
+
 void Workflow::rewriteCFString(LLILFunctionRef ssa, size_t insnIndex)
 {
     const auto bv = ssa->GetFunction()->GetView();
@@ -82,10 +167,12 @@ void Workflow::rewriteCFString(LLILFunctionRef ssa, size_t insnIndex)
     auto sourceExpr = insn.GetSourceExpr<LLIL_SET_REG_SSA>();
     auto destRegister = llilInsn.GetDestRegister();
 
+    // The data pointer is the third pointer-sized field of a CFString.
+    auto addressSize = bv->GetDefaultArchitecture()->GetAddressSize();
     auto addr = sourceExpr.GetValue().value;
-    auto stringPointer = addr + 0x10;
-    uint64_t dest;
-    bv->Read(&dest, stringPointer, bv->GetDefaultArchitecture()->GetAddressSize());
+    auto stringPointer = addr + 2 * addressSize;
+    uint64_t dest = 0;
+    bv->Read(&dest, stringPointer, addressSize);
 
     auto targetPointer = llil->ConstPointer(bv->GetAddressSize(), dest, llilInsn);
     auto cfstrCall = llil->Intrinsic({ BinaryNinja::RegisterOrFlag(0, destRegister) }, CFSTRIntrinsicIndex, {targetPointer}, 0, llilInsn);
@@ -96,15 +183,287 @@ void Workflow::rewriteCFString(LLILFunctionRef ssa, size_t insnIndex)
     llil->Finalize();
 }
 
-void Workflow::inlineMethodCalls(AnalysisContextRef ac)
+void Workflow::analyzeSharedCacheImages(BinaryViewRef bv)
 {
-    const auto func = ac->GetFunction();
-    const auto arch = func->GetArchitecture();
-    const auto bv = func->GetView();
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    const auto tables = GlobalState::sharedCacheTables(bv);
+
+    // Images analyzed before keep their info; only new ones are read.
+    std::vector<std::string> names;
+    std::vector<ObjectiveNinja::SharedAbstractFile> images;
+    for (const auto& name : ObjectiveNinja::BinaryViewFile::objcImageNames(bv)) {
+        if (tables->claimImage(name)) {
+            names.push_back(name);
+            images.push_back(std::make_shared<ObjectiveNinja::BinaryViewFile>(bv, true, name));
+        }
+    }
 
-    if (GlobalState::viewIsIgnored(bv))
+    if (images.empty())
         return;
 
+    // Failed images are released again, so they are retried the next time
+    // sections change, e.g. if the failure was caused by an image that was
+    // not loaded yet.
+    std::vector<std::exception_ptr> errors;
+    try {
+        auto infos = InfoHandler::analyzeAndApplyImages(images, tables, PluginSettings::analysisOptions(bv), bv, &errors);
+        for (size_t i = 0; i < infos.size(); ++i) {
+            auto& info = infos[i];
+            if (!info) {
+                log->LogError("Structure analysis failed for shared cache image '%s': %s", names[i].c_str(),
+                    describeError(errors[i]).c_str());
+                tables->releaseImage(names[i]);
+                continue;
+            }
+
+            // Needed to read deferred method lists from the right image.
+            info->imageName = names[i];
+
+            // Class names are in the shared class table by now, so classes
+            // are only needed if their methods are still to be applied.
+            if (!info->hasDeferredMethods())
+                info->releaseRecords();
+
+            GlobalState::addImageAnalysisInfo(bv, std::move(info));
+        }
+    } catch (...) {
+        log->LogError("Shared cache image analysis failed: %s", describeError(std::current_exception()).c_str());
+        for (const auto& name : names)
+            tables->releaseImage(name);
+    }
+}
+
+bool Workflow::shouldCacheInfo(BinaryViewRef bv)
+{
+    // Shared cache views have no info of their own worth caching.
+    if (bv->GetTypeName() == SharedCacheViewTypeName)
+        return false;
+
+    return PluginSettings::storeAnalysisInView(bv) || !PluginSettings::analysisCacheDirectory(bv).empty();
+}
+
+SharedAnalysisInfo Workflow::loadCachedInfo(BinaryViewRef bv, const ObjectiveNinja::CacheKey& key)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+
+    if (PluginSettings::storeAnalysisInView(bv)) {
+        auto data = GlobalState::savedAnalysisInfo(bv, key.toString());
+        if (!data.empty()) {
+            try {
+                auto info = ObjectiveNinja::InfoSerializer::deserialize(data.data(), data.size());
+                log->LogInfo("Loaded structure analysis from database metadata");
+                return info;
+            } catch (const ObjectiveNinja::SerializationError& e) {
+                log->LogWarn("Ignoring saved structure analysis: %s", e.what());
+            }
+        }
+    }
+
+    auto directory = PluginSettings::analysisCacheDirectory(bv);
+    if (!directory.empty()) {
+        if (auto info = ObjectiveNinja::AnalysisCache(directory).load(key)) {
+            log->LogInfo("Loaded structure analysis from cache (%s)", key.toString().c_str());
+            return info;
+        }
+    }
+
+    return nullptr;
+}
+
+void Workflow::cacheInfo(BinaryViewRef bv, const ObjectiveNinja::CacheKey& key, const ObjectiveNinja::AnalysisInfo& info)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+    const auto keyText = key.toString();
+
+    const auto storeInView = PluginSettings::storeAnalysisInView(bv) && !GlobalState::hasSavedAnalysisInfo(bv, keyText);
+
+    const auto directory = PluginSettings::analysisCacheDirectory(bv);
+    const auto storeInDirectory = !directory.empty() && !ObjectiveNinja::AnalysisCache(directory).contains(key);
+
+    if (!storeInView && !storeInDirectory)
+        return;
+
+    const auto data = ObjectiveNinja::InfoSerializer::serialize(info);
+
+    if (storeInView)
+        GlobalState::saveAnalysisInfo(bv, keyText, data);
+
+    if (storeInDirectory) {
+        if (ObjectiveNinja::AnalysisCache(directory).store(key, data))
+            log->LogDebug("Cached structure analysis (%s, %zu bytes)", keyText.c_str(), data.size());
+        else
+            log->LogWarn("Failed to write structure analysis cache entry to '%s'", directory.c_str());
+    }
+}
+
+void Workflow::reloadEvictedInfo(BinaryViewRef bv)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+
+    SharedAnalysisInfo info;
+    try {
+        auto file = std::make_shared<ObjectiveNinja::BinaryViewFile>(bv);
+        if (shouldCacheInfo(bv))
+            info = loadCachedInfo(bv, ObjectiveNinja::CacheKey::forFile(*file));
+
+        if (!info) {
+            // Deferred methods would be applied to the view again once
+            // resolved, so they are parsed right away instead.
+            auto options = PluginSettings::analysisOptions(bv);
+            options.lazyMethodLists = false;
+
+            info = ObjectiveNinja::AnalysisProvider::infoForFile(file, options);
+        }
+
+        // The info is already applied to the view, so only the tables used
+        // for lookups are needed.
+        info->releaseRecords();
+
+        log->LogDebug("Reloaded evicted structure analysis");
+    } catch (...) {
+        log->LogError("Failed to reload structure analysis; binary may be malformed.");
+    }
+
+    GlobalState::storeAnalysisInfo(bv, info);
+}
+
+void Workflow::analyzeStructures(BinaryViewRef bv, BinaryNinja::BackgroundTask* task)
+{
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+
+    SharedAnalysisInfo info;
+    CustomTypes::defineAll(bv);
+    auto messageHandler = GlobalState::messageHandler(bv);
+
+    try {
+        auto file = std::make_shared<ObjectiveNinja::BinaryViewFile>(bv);
+
+        const bool useCache = shouldCacheInfo(bv);
+        ObjectiveNinja::CacheKey cacheKey;
+        if (useCache) {
+            cacheKey = ObjectiveNinja::CacheKey::forFile(*file);
+            info = loadCachedInfo(bv, cacheKey);
+        }
+
+        // Nothing has been applied to the view yet, so the view is left as
+        // it was; function activities analyze it when they need to.
+        if (task && task->IsCancelled()) {
+            log->LogInfo("Background structure analysis cancelled");
+            return;
+        }
+
+        if (info) {
+            // A database saved after structure analysis already has
+            // the info applied; only a fresh view needs it.
+            if (!GlobalState::hasFlag(bv, Flag::DidRunStructureAnalysis))
+                InfoHandler::applyInfoToView(info, bv);
+
+            // Keep the view's metadata up to date when the info came
+            // from the cache directory.
+            cacheInfo(bv, cacheKey, *info);
+        } else {
+            std::function<void(size_t)> onProgress;
+            std::function<bool()> isCancelled;
+            if (task) {
+                onProgress = [task](size_t classes) {
+                    task->SetProgressText("Objective-C: Analyzing structures (" + std::to_string(classes) + " classes)...");
+                };
+                isCancelled = [task] { return task->IsCancelled(); };
+            }
+
+            info = InfoHandler::analyzeAndApply(file, PluginSettings::analysisOptions(bv), bv, useCache, onProgress,
+                isCancelled);
+
+            // Deferred infos are cached once their methods are
+            // resolved; see finishResolvedMethods().
+            if (useCache && !info->hasDeferredMethods())
+                cacheInfo(bv, cacheKey, *info);
+        }
+
+        // Classes and CFStrings were only kept for caching. If methods are
+        // deferred, classes are needed to resolve them and are released
+        // once that is done instead.
+        if (!info->hasDeferredMethods())
+            info->releaseRecords();
+
+        auto cacheStats = file->cacheStats();
+        log->LogDebug("Section cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " bytes",
+            cacheStats.hits, cacheStats.misses, cacheStats.bytes);
+
+        const auto msgSendFunctions = messageHandler->getMessageSendFunctions();
+        for (auto addr : msgSendFunctions)
+        {
+            BinaryNinja::QualifiedNameAndType nameAndType;
+            std::string errors;
+            std::set<BinaryNinja::QualifiedName> typesAllowRedefinition;
+
+            // void *
+            auto retType = BinaryNinja::Confidence<BinaryNinja::Ref<BinaryNinja::Type>>(
+                    BinaryNinja::Type::PointerType(bv->GetAddressSize(),BinaryNinja::Type::VoidType(), 
+                    0));
+
+            std::vector<BinaryNinja::FunctionParameter> params;
+            auto cc = bv->GetDefaultPlatform()->GetDefaultCallingConvention();
+
+            params.push_back({"self",
+                BinaryNinja::Type::NamedType(bv, {"id"}),
+                true,
+                BinaryNinja::Variable()});
+            params.push_back({"sel",
+                BinaryNinja::Type::PointerType(bv->GetAddressSize(), BinaryNinja::Type::IntegerType(1, false)),
+                true,
+                BinaryNinja::Variable()});
+
+            auto funcType = BinaryNinja::Type::FunctionType(retType, cc, params, true);
+            bv->DefineDataVariable(addr, BinaryNinja::Type::PointerType(bv->GetDefaultArchitecture(), funcType));
+        }
+    } catch (const ObjectiveNinja::AnalysisCancelled&) {
+        // Structures applied so far are left in the view; they are applied
+        // again, along with the rest, once a function needs the analysis.
+        log->LogInfo("Background structure analysis cancelled");
+        return;
+    } catch (...) {
+        log->LogError("Structure analysis failed; binary may be malformed.");
+        log->LogError("Objective-C analysis will not be applied due to previous errors.");
+    }
+
+    GlobalState::setFlag(bv, Flag::DidRunStructureAnalysis);
+    GlobalState::storeAnalysisInfo(bv, info);
+
+    // Images are loaded into shared cache views over time, and each
+    // one's metadata lives in its own prefixed sections.
+    if (bv->GetTypeName() == SharedCacheViewTypeName)
+        GlobalState::watchSections(bv);
+
+    GlobalState::limitResidentViews(PluginSettings::maxResidentViews());
+}
+
+std::shared_ptr<const ViewSnapshot> Workflow::prepareView(BinaryViewRef bv, BinaryNinja::BackgroundTask* task)
+{
+    // Once a view is analyzed, its snapshot says so and the mutex is skipped
+    // entirely.
+    auto snapshot = GlobalState::snapshot(bv);
+    if (snapshot && !snapshot->needsAnalysis())
+        return snapshot;
+
+    const auto analysisMutex = GlobalState::analysisMutex(bv);
+    std::scoped_lock<std::mutex> lock(*analysisMutex);
+
+    if (GlobalState::wasEvicted(bv)) {
+        reloadEvictedInfo(bv);
+        GlobalState::limitResidentViews(PluginSettings::maxResidentViews());
+    } else if (!GlobalState::hasAnalysisInfo(bv)) {
+        analyzeStructures(bv, task);
+    }
+
+    if (GlobalState::takeSectionsChanged(bv))
+        analyzeSharedCacheImages(bv);
+
+    return GlobalState::snapshot(bv);
+}
+
+bool Workflow::checkArchitecture(BinaryViewRef bv)
+{
     const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
 
     // Ignore the view if it has an unsupported architecture.
@@ -115,80 +474,89 @@ void Workflow::inlineMethodCalls(AnalysisContextRef ac)
     // defined successfully.
     auto defaultArch = bv->GetDefaultArchitecture();
     auto defaultArchName = defaultArch ? defaultArch->GetName() : "";
-    if (defaultArchName != "aarch64" && defaultArchName != "x86_64") {
+    if (defaultArchName != "aarch64" && defaultArchName != "x86_64"
+        && defaultArchName != "armv7" && defaultArchName != "thumb2") {
         if (!defaultArch)
             log->LogError("View must have a default architecture.");
         else
             log->LogError("Architecture '%s' is not supported", defaultArchName.c_str());
 
         GlobalState::addIgnoredView(bv);
-        return;
+        return false;
     }
 
-    // The workflow relies on some data acquired through analysis of Objective-C
-    // structures present in the binary. The structure analysis must run
-    // exactly once per binary. Until the Workflows API supports a "run once"
-    // idiom, this is accomplished through a mutex and a check for present
-    // analysis information.
-    {
-        std::scoped_lock<std::mutex> lock(g_initialAnalysisMutex);
+    return true;
+}
 
-        if (!GlobalState::hasAnalysisInfo(bv)) {
-            SharedAnalysisInfo info;
-            CustomTypes::defineAll(bv);
-            auto messageHandler = GlobalState::messageHandler(bv);
+void Workflow::startBackgroundAnalysis(BinaryViewRef bv)
+{
+    if (!PluginSettings::backgroundAnalysis(bv))
+        return;
 
-            try {
-                auto file = std::make_shared<ObjectiveNinja::BinaryViewFile>(bv);
+    // Only views analyzed with this workflow need structure analysis.
+    auto settings = BinaryNinja::Settings::Instance();
+    if (settings->Get<std::string>("analysis.workflows.functionWorkflow", bv) != WorkflowName)
+        return;
 
-                auto start = Performance::now();
-                info = ObjectiveNinja::AnalysisProvider::infoForFile(file);
-                auto elapsed = Performance::elapsed<std::chrono::milliseconds>(start);
+    // Views without an architecture (such as raw views) are skipped quietly
+    // rather than being reported and ignored.
+    if (!bv->GetDefaultArchitecture() || GlobalState::viewIsIgnored(bv) || !checkArchitecture(bv))
+        return;
 
-                const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
-                log->LogInfo("Structures analyzed in %lu ms", elapsed.count());
+    BinaryNinja::WorkerEnqueue([bv] {
+        BinaryNinja::Ref<BinaryNinja::BackgroundTask> task
+            = new BinaryNinja::BackgroundTask("Objective-C: Analyzing structures...", true);
 
-                InfoHandler::applyInfoToView(info, bv);
+        try {
+            prepareView(bv, task);
+        } catch (...) {
+            const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+            log->LogError("Background structure analysis failed.");
+        }
 
-                const auto msgSendFunctions = messageHandler->getMessageSendFunctions();
-                for (auto addr : msgSendFunctions)
-                {
-                    BinaryNinja::QualifiedNameAndType nameAndType;
-                    std::string errors;
-                    std::set<BinaryNinja::QualifiedName> typesAllowRedefinition;
-
-                    // void *
-                    auto retType = BinaryNinja::Confidence<BinaryNinja::Ref<BinaryNinja::Type>>(
-                            BinaryNinja::Type::PointerType(bv->GetAddressSize(),BinaryNinja::Type::VoidType(), 
-                            0));
-
-                    std::vector<BinaryNinja::FunctionParameter> params;
-                    auto cc = bv->GetDefaultPlatform()->GetDefaultCallingConvention();
-
-                    params.push_back({"self",
-                        BinaryNinja::Type::NamedType(bv, {"id"}),
-                        true,
-                        BinaryNinja::Variable()});
-                    params.push_back({"sel",
-                        BinaryNinja::Type::PointerType(bv->GetAddressSize(), BinaryNinja::Type::IntegerType(1, false)),
-                        true,
-                        BinaryNinja::Variable()});
-
-                    auto funcType = BinaryNinja::Type::FunctionType(retType, cc, params, true);
-                    bv->DefineDataVariable(addr, BinaryNinja::Type::PointerType(bv->GetDefaultArchitecture(), funcType));
-                }
-            } catch (...) {
-                log->LogError("Structure analysis failed; binary may be malformed.");
-                log->LogError("Objective-C analysis will not be applied due to previous errors.");
-            }
+        task->Finish();
+    }, "Objective-C structure analysis");
+}
 
-            GlobalState::setFlag(bv, Flag::DidRunStructureAnalysis);
-            GlobalState::storeAnalysisInfo(bv, info);
-        }
-    }
+void Workflow::inlineMethodCalls(AnalysisContextRef ac)
+{
+    const auto func = ac->GetFunction();
+    const auto arch = func->GetArchitecture();
+    const auto bv = func->GetView();
 
-    auto messageHandler = GlobalState::messageHandler(bv);
+    if (GlobalState::viewIsIgnored(bv))
+        return;
+
+    const auto log = BinaryNinja::LogRegistry::GetLogger(PluginLoggerName);
+
+    if (!checkArchitecture(bv))
+        return;
+
+    // The workflow relies on some data acquired through analysis of Objective-C
+    // structures present in the binary. The structure analysis must run
+    // exactly once per binary, and is normally started in the background when
+    // the view is opened; see startBackgroundAnalysis(). Functions only wait
+    // for it once they reach an instruction that needs it.
+    //
+    // The snapshot is held for the rest of the function, so that the infos
+    // stay usable even if they are evicted or replaced in the meantime.
+    std::shared_ptr<const ViewSnapshot> snapshot = GlobalState::snapshot(bv);
+    if (snapshot && snapshot->needsAnalysis())
+        snapshot = nullptr;
+
+    const auto requireAnalysis = [&]() -> const ViewSnapshot& {
+        if (!snapshot)
+            snapshot = prepareView(bv);
+
+        return *snapshot;
+    };
+
+    const auto messageHandler = GlobalState::messageHandler(bv);
     if (!messageHandler->hasMessageSendFunctions()) {
+        // Structures are still applied to the view, even if calls cannot be
+        // rewritten.
+        requireAnalysis();
+
         log->LogError("Cannot perform Objective-C IL cleanup; no objc_msgSend candidates found");
         GlobalState::addIgnoredView(bv);
         return;
@@ -205,7 +573,10 @@ void Workflow::inlineMethodCalls(AnalysisContextRef ac)
         return;
     }
 
-    const auto rewriteIfEligible = [bv, messageHandler, ssa](size_t insnIndex) {
+    // Only needed until the view has been analyzed.
+    std::shared_ptr<const SectionRanges> cfStringRanges;
+
+    const auto rewriteIfEligible = [&](size_t insnIndex) {
         auto insn = ssa->GetInstruction(insnIndex);
 
         if (insn.operation == LLIL_CALL_SSA)
@@ -224,13 +595,29 @@ void Workflow::inlineMethodCalls(AnalysisContextRef ac)
                 || params[1].operation != LLIL_REG_SSA)
                 return;
 
-            rewriteMethodCall(ssa, insnIndex);
+            rewriteMethodCall(ssa, insnIndex, requireAnalysis().infos);
 
         }
         else if (insn.operation == LLIL_SET_REG_SSA)
         {
+            // Only registers set to a known constant can hold a CFString
+            // address.
             auto sourceExpr = insn.GetSourceExpr<LLIL_SET_REG_SSA>();
-            auto addr = sourceExpr.GetValue().value;
+            auto value = sourceExpr.GetValue();
+            if (value.state != ConstantValue && value.state != ConstantPointerValue)
+                return;
+            auto addr = value.value;
+
+            // CFString variables are only defined once structures are
+            // applied, so wait for that if the address could be one.
+            if (!snapshot) {
+                if (!cfStringRanges)
+                    cfStringRanges = GlobalState::cfStringRanges(bv);
+                if (!cfStringRanges->contains(addr))
+                    return;
+            }
+            requireAnalysis();
+
             BinaryNinja::DataVariable var;
             if (!bv->GetDataVariableAtAddress(addr, var) || var.type->GetString() != "struct CFString")
                 return;
@@ -252,10 +639,13 @@ static constexpr auto WorkflowInfo = R"({
 
 void Workflow::registerActivities()
 {
-    const auto wf = BinaryNinja::Workflow::Instance()->Clone("core.function.objectiveC");
+    const auto wf = BinaryNinja::Workflow::Instance()->Clone(WorkflowName);
     wf->RegisterActivity(new BinaryNinja::Activity(
         ActivityID::ResolveMethodCalls, &Workflow::inlineMethodCalls));
     wf->Insert("core.function.translateTailCalls", ActivityID::ResolveMethodCalls);
 
     BinaryNinja::Workflow::RegisterWorkflow(wf, WorkflowInfo);
+
+    BinaryNinja::BinaryViewEvent::RegisterEventCallback(BinaryViewFinalizationEvent,
+        [](BinaryViewRef bv) { startBackgroundAnalysis(bv); });
 }
@@ -9,6 +9,12 @@
 
 #include "BinaryNinja.h"
 
+#include "Core/AnalysisCache.h"
+
+struct ViewSnapshot;
+
+constexpr auto WorkflowName = "core.function.objectiveC";
+
 /**
  * Namespace to hold activity ID constants.
  */
@@ -28,8 +34,17 @@ class Workflow {
      * call to the requested method's implementation.
      *
      * @param insnIndex The index of the `LLIL_CALL` instruction to rewrite
+     * @param infos The view's analysis info, as returned by
+     * GlobalState::allAnalysisInfo()
      */
-    static void rewriteMethodCall(LLILFunctionRef, size_t insnIndex);
+    static void rewriteMethodCall(LLILFunctionRef, size_t insnIndex,
+        const std::vector<std::shared_ptr<ObjectiveNinja::AnalysisInfo>>& infos);
+
+    /**
+     * Apply the method info of an info whose deferred method lists were just
+     * resolved, and cache the info, on a worker thread.
+     */
+    static void finishResolvedMethods(BinaryViewRef, std::shared_ptr<ObjectiveNinja::AnalysisInfo>);
 
     /**
      * Rewrite a CFString reference to a direct string reference and matching CFSTR intrinsic call.
@@ -38,6 +53,63 @@ class Workflow {
      */
     static void rewriteCFString(LLILFunctionRef, size_t insnIndex);
 
+    /**
+     * Analyze the shared cache images loaded in a view which have not been
+     * analyzed yet, and apply the results to the view.
+     */
+    static void analyzeSharedCacheImages(BinaryViewRef);
+
+    /**
+     * Load the analysis info saved in a view's metadata or in the cache
+     * directory for the given key, or null if neither has a valid entry.
+     */
+    static std::shared_ptr<ObjectiveNinja::AnalysisInfo> loadCachedInfo(BinaryViewRef, const ObjectiveNinja::CacheKey&);
+
+    /**
+     * Save complete analysis info to a view's metadata and the cache
+     * directory, as enabled by the view's settings.
+     */
+    static void cacheInfo(BinaryViewRef, const ObjectiveNinja::CacheKey&, const ObjectiveNinja::AnalysisInfo&);
+
+    /**
+     * Check if analysis info should be cached for a view at all.
+     */
+    static bool shouldCacheInfo(BinaryViewRef);
+
+    /**
+     * Get the analysis info of a view back after it was evicted, from the
+     * cache if possible, or by analyzing the view again. The info is not
+     * applied to the view again.
+     */
+    static void reloadEvictedInfo(BinaryViewRef);
+
+    /**
+     * Run structure analysis on a view and apply the results to it. If a
+     * background task is given, progress is reported through it, and the
+     * analysis stops without storing anything if it is cancelled, leaving
+     * the view to be analyzed again once a function needs it.
+     */
+    static void analyzeStructures(BinaryViewRef, BinaryNinja::BackgroundTask* task = nullptr);
+
+    /**
+     * Make sure a view's structures are analyzed, including newly loaded
+     * shared cache images, and get its current snapshot. Blocks while
+     * another thread is analyzing the same view.
+     */
+    static std::shared_ptr<const ViewSnapshot> prepareView(BinaryViewRef, BinaryNinja::BackgroundTask* task = nullptr);
+
+    /**
+     * Check if a view has a supported default architecture, ignoring the view
+     * if not.
+     */
+    static bool checkArchitecture(BinaryViewRef);
+
+    /**
+     * Start structure analysis of a newly opened view in the background, so
+     * it overlaps with initial function analysis.
+     */
+    static void startBackgroundAnalysis(BinaryViewRef);
+
 public:
     /**
      * Attempt to inline all `objc_msgSend` calls in the given analysis context.